@@ -0,0 +1,346 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+/**
+ *
+ * \file     bench.c
+ * \brief    Runs the Forth benchmarks of this directory on the host and compares them against a baseline
+ *
+ *           Usage: forth-bench [-t ms] [-b baseline] [-w baseline] script.fs ...
+ *
+ *           Every script defines BENCH ( -- n ), one operation of the benchmark, and names the value BENCH has to
+ *           leave in a "\ expect:" comment. The script is loaded behind a marker, BENCH is executed once to check
+ *           the result and count the words the inner interpreter dispatches, then as often as it takes to run for
+ *           at least -t milliseconds (200 by default). The best of three such rounds gives the time per
+ *           operation. Everything the VM prints goes to /dev/null, the report goes to the original stdout.
+ *
+ *           -b compares the results against a baseline written by -w. The instruction counts of a baseline are
+ *           exact and should only change with the compiler, the times only mean something on the same machine.
+ *           The dictionary bytes a script takes are reported too, forth-bench-token runs the same scripts on
+ *           FORTH_TOKEN_CODE so that the space the tokens save can be held against the cost of decoding them.
+ *
+ *           The VM is built into this program with FORTH_COUNT_INSNS, so the times include one increment per
+ *           dispatched word. On the board, run.fs reports the cycles of every benchmark with CYCLES instead.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "forthFunctions.h"
+#include "interprter.h"
+#include "stack.h"
+#include "CoreForth.h"
+#include "utils.h"
+#include "forth_files.h"
+
+#define MAX_BENCH        32             /**< Most scripts in one run, and entries in a baseline */
+#define NAME_SIZE        32             /**< Longest benchmark name */
+#define ROUNDS           3              /**< Timed rounds per benchmark, the best one counts */
+#define DEF_MIN_MS       200            /**< Default shortest round */
+
+typedef struct {
+    char name[NAME_SIZE];
+    double ns;                          /**< nanoseconds per operation */
+    unsigned long insns;                /**< words dispatched per operation */
+    unsigned long bytes;                /**< dictionary space the script takes */
+} BenchResult;
+
+extern int CmdPos;
+
+
+/**
+ *  \fn         RunLine(char* line)
+ *  \brief      Interprets one line as if it had been typed in
+ */
+
+static int RunLine(char* line) {
+    int res = CONTINUE_FORTH_INTERPRET;
+
+    strcpy(CmdBuff, line);
+    RESET_CMDPOS;
+    while (!IS_EOL(CmdBuff[CmdPos])) {
+        res = Interpret();
+        if (res == COMPILE_ERROR || res == STOP_FORTH_INTERPRET) {
+            break;
+        }
+    }
+    RESET_CMDPOS;
+    return res;
+}
+
+/**
+ *  \fn         ExpectedResult(char* path, cell* val)
+ *  \brief      Reads the "\ expect: n" comment of a script
+ *
+ *  \return     1 if the script has one, 0 otherwise
+ */
+
+static int ExpectedResult(char* path, cell* val) {
+    char line[BUFFER_SIZE];
+    char* pos;
+    FILE* fp;
+    int found = 0;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return 0;
+    }
+    while (!found && fgets(line, sizeof(line), fp) != NULL) {
+        pos = strstr(line, "\\ expect:");
+        if (pos != NULL) {
+            *val = (cell)strtoll(pos + strlen("\\ expect:"), NULL, 0);
+            found = 1;
+        }
+    }
+    fclose(fp);
+    return found;
+}
+
+/**
+ *  \fn         BenchName(char* path, char* name)
+ *  \brief      Names a benchmark after its script, without directory and extension
+ */
+
+static void BenchName(char* path, char* name) {
+    char* base = strrchr(path, '/');
+    char* dot;
+
+    base = (base == NULL) ? path : base + 1;
+    strncpy(name, base, NAME_SIZE - 1);
+    name[NAME_SIZE - 1] = '\0';
+    dot = strrchr(name, '.');
+    if (dot != NULL) {
+        *dot = '\0';
+    }
+}
+
+/**
+ *  \fn         TimeRuns(cell xt, long reps)
+ *  \brief      Executes BENCH \a reps times
+ *
+ *  \return     elapsed nanoseconds
+ */
+
+static ucell TimeRuns(cell xt, long reps) {
+    ucell start;
+    long i;
+    int cond;
+
+    start = ReadCycles();
+    for (i=0; i<reps; i++) {
+        Execute(xt);
+        PopDs(&cond);
+    }
+    return ReadCycles() - start;
+}
+
+/**
+ *  \fn         RunBench(char* path, ucell min_ns, BenchResult* res, FILE* rep)
+ *  \brief      Loads one script, checks and times its BENCH word and forgets the script again
+ *
+ *  \return     0 on success, 1 if the script does not load or BENCH misbehaves
+ */
+
+static int RunBench(char* path, ucell min_ns, BenchResult* res, FILE* rep) {
+    cell xt, expect, got;
+    char* here;
+    ucell t, best;
+    long reps;
+    int cond, i, err = 0;
+
+    BenchName(path, res->name);
+    DatStackTop = 0;
+    RunLine("MARKER (BENCH-MARK)");
+    here = DicHere;
+
+    if (ExecFromFile(path) != EXECUTION_COMPLETE || Find("BENCH", &xt) != FORTH_WORD_FOUND) {
+        fprintf(rep, "%-12s does not load, try it with forth-repl\n", res->name);
+        err = 1;
+    } else if (!ExpectedResult(path, &expect)) {
+        fprintf(rep, "%-12s has no \"\\ expect:\" line\n", res->name);
+        err = 1;
+    } else {
+        res->bytes = DicHere - here;
+        InsnCount = 0;
+        DatStackTop = 0;
+        Execute(xt);
+        res->insns = InsnCount;
+        got = PopDs(&cond);
+        if (cond == STACK_ERR_EMPTY || DatStackTop != 0 || got != expect) {
+            fprintf(rep, "%-12s BENCH left " CELL_FMT " with %d more cells, expected " CELL_FMT "\n",
+                    res->name, got, DatStackTop, expect);
+            err = 1;
+        }
+    }
+
+    if (err == 0) {
+        for (reps=1; (t = TimeRuns(xt, reps)) < min_ns; reps*=2) {
+        }
+        best = t;
+        for (i=1; i<ROUNDS; i++) {
+            t = TimeRuns(xt, reps);
+            if (t < best) {
+                best = t;
+            }
+        }
+        res->ns = (double)best / reps;
+    }
+
+    RunLine("(BENCH-MARK)");
+    return err;
+}
+
+/**
+ *  \fn         ReadBaseline(char* path, BenchResult* base)
+ *  \brief      Reads a baseline written by WriteBaseline()
+ *
+ *  \return     number of entries, -1 if the file cannot be opened
+ */
+
+static int ReadBaseline(char* path, BenchResult* base) {
+    char line[128];
+    FILE* fp;
+    int n = 0, got;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    while (n < MAX_BENCH && fgets(line, sizeof(line), fp) != NULL) {
+        base[n].bytes = 0;                      // older baselines have no bytes
+        got = sscanf(line, "%31s %lf %lu %lu", base[n].name, &base[n].ns, &base[n].insns, &base[n].bytes);
+        if (line[0] != '#' && got >= 3) {
+            n++;
+        }
+    }
+    fclose(fp);
+    return n;
+}
+
+/**
+ *  \fn         WriteBaseline(char* path, BenchResult* res, int n)
+ *  \brief      Stores the results of this run for later comparison
+ */
+
+static int WriteBaseline(char* path, BenchResult* res, int n) {
+    FILE* fp;
+    int i;
+
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        return 1;
+    }
+    fprintf(fp, "# forth-bench baseline, cell size %d\n", (int)sizeof(cell));
+    fprintf(fp, "# name ns/op insns/op bytes\n");
+    for (i=0; i<n; i++) {
+        fprintf(fp, "%s %.1f %lu %lu\n", res[i].name, res[i].ns, res[i].insns, res[i].bytes);
+    }
+    fclose(fp);
+    return 0;
+}
+
+/**
+ *  \fn         Report(FILE* rep, BenchResult* res, BenchResult* base, int nbase)
+ *  \brief      Prints one result and its change against the baseline entry of the same name
+ */
+
+static void Report(FILE* rep, BenchResult* res, BenchResult* base, int nbase) {
+    int i;
+
+    fprintf(rep, "%-12s %12.1f %12lu %8.2f %8lu", res->name, res->ns, res->insns, res->ns / res->insns,
+            res->bytes);
+    for (i=0; i<nbase; i++) {
+        if (strcmp(base[i].name, res->name) == 0) {
+            fprintf(rep, "  %+7.1f%% %+7.1f%%", 100.0 * (res->ns - base[i].ns) / base[i].ns,
+                    100.0 * ((double)res->insns - (double)base[i].insns) / (double)base[i].insns);
+            if (base[i].bytes != 0) {
+                fprintf(rep, " %+7.1f%%", 100.0 * ((double)res->bytes - (double)base[i].bytes) / (double)base[i].bytes);
+            }
+            break;
+        }
+    }
+    fprintf(rep, "\n");
+}
+
+
+int main(int argc, char** argv) {
+    BenchResult res[MAX_BENCH], base[MAX_BENCH];
+    char *base_path = NULL, *out_path = NULL;
+    ucell min_ns = (ucell)DEF_MIN_MS * 1000000;
+    int i, n = 0, nbase = 0, failed = 0;
+    FILE* rep;
+
+    for (i=1; i<argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i+1 < argc) {
+            base_path = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i+1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            min_ns = (ucell)atol(argv[++i]) * 1000000;
+        } else {
+            break;
+        }
+    }
+    if (i == argc || argv[i][0] == '-') {
+        fprintf(stderr, "usage: %s [-t ms] [-b baseline] [-w baseline] script.fs ...\n", argv[0]);
+        return 2;
+    }
+
+    if (base_path != NULL) {
+        nbase = ReadBaseline(base_path, base);
+        if (nbase < 0) {
+            fprintf(stderr, "cannot read baseline %s\n", base_path);
+            return 2;
+        }
+    }
+
+    rep = fdopen(dup(fileno(stdout)), "w");     // the VM prints to stdout, which is silenced
+    fflush(stdout);
+    if (rep == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "cannot redirect the output of the VM\n");
+        return 2;
+    }
+
+    init_dictionary();
+    RESET_CMDPOS;
+
+    fprintf(rep, "%-12s %12s %12s %8s %8s%s\n", "bench", "ns/op", "insns/op", "ns/insn", "dict B",
+            nbase > 0 ? "  ns/op  insns/op  dict B vs baseline" : "");
+    for (; i<argc && n<MAX_BENCH; i++) {
+        if (RunBench(argv[i], min_ns, &res[n], rep) != 0) {
+            failed = 1;
+            continue;
+        }
+        Report(rep, &res[n], base, nbase);
+        fflush(rep);
+        n++;
+    }
+
+    if (out_path != NULL && WriteBaseline(out_path, res, n) != 0) {
+        fprintf(stderr, "cannot write baseline %s\n", out_path);
+        failed = 1;
+    }
+    return failed;
+}
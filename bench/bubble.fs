@@ -0,0 +1,30 @@
+\ Bubble sort of 200 pseudo random cells, leaves the number of adjacent
+\ pairs found in order afterwards
+\ expect: 199
+
+variable arr  here arr ! 200 cells allot
+variable seed  variable bi  variable bj  variable bn
+
+: a@ ( i -- x ) cells arr @ + @ ;
+: a! ( x i -- ) cells arr @ + ! ;
+
+: bfill ( -- )
+  12345 seed ! 0 bi !
+  begin seed @ 25173 * 13849 + 65535 and dup seed ! bi @ a! bi @ 1 + dup bi ! 200 = until ;
+
+: bsort ( -- )
+  199 bn !
+  begin
+    0 bj !
+    begin
+      bj @ a@ bj @ 1 + a@ over over > if bj @ a! bj @ 1 + a! else drop drop then
+      bj @ 1 + dup bj ! bn @ =
+    until
+    bn @ 1 - dup bn ! 0 =
+  until ;
+
+: bcheck ( -- n )
+  0 0 bi !
+  begin bi @ a@ bi @ 1 + a@ <= if 1 + then bi @ 1 + dup bi ! 199 = until ;
+
+: bench ( -- n ) bfill bsort bcheck ;
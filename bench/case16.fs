@@ -0,0 +1,13 @@
+\ CASE dispatch over 16 dense values, 1024 selections, see case4.fs
+\ expect: 8704
+
+: sel ( n -- n )
+  case
+    0 of 1 endof    1 of 2 endof    2 of 3 endof    3 of 4 endof
+    4 of 5 endof    5 of 6 endof    6 of 7 endof    7 of 8 endof
+    8 of 9 endof    9 of 10 endof   10 of 11 endof  11 of 12 endof
+    12 of 13 endof  13 of 14 endof  14 of 15 endof  15 of 16 endof
+    0 swap
+  endcase ;
+
+: bench ( -- n ) 0 1024 0 do i 15 and sel + loop ;
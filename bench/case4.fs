@@ -0,0 +1,12 @@
+\ CASE dispatch over 4 dense values, 1024 selections; case16.fs does the
+\ same over 16. Both compile to a jump table, so a selection costs the
+\ same however many clauses the CASE has
+\ expect: 2560
+
+: sel ( n -- n )
+  case
+    0 of 1 endof  1 of 2 endof  2 of 3 endof  3 of 4 endof
+    0 swap
+  endcase ;
+
+: bench ( -- n ) 0 1024 0 do i 3 and sel + loop ;
@@ -0,0 +1,212 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file     compile_bench.c
+ * \brief    Times reading and compiling a script, the outer interpreter rather than the inner one
+ *
+ *           Usage: compile-bench [script.fs] [passes]
+ *
+ *           The script (../ForthScripts/ha.fs by default) is read into memory once and then interpreted line by
+ *           line behind a marker, which is executed after every pass so that each pass defines the same words
+ *           again. The best of three rounds gives the time per pass and per line. The GUI and peripheral words
+ *           the script uses are stand-ins, which take their arguments off the stack and read their names from
+ *           the input like the real ones and do nothing else. Everything the VM prints goes to /dev/null. This
+ *           runs on the host, it is linked against the forth library of the CMake build:
+ *
+ *           cmake --build build --target bench-compile
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "forthFunctions.h"
+#include "interprter.h"
+#include "stack.h"
+#include "CoreForth.h"
+#include "utils.h"
+
+#define MAX_LINES        1024           /**< Longest script */
+#define ROUNDS           3              /**< Timed rounds, the best one counts */
+#define DEF_PASSES       2000           /**< Passes over the script per round */
+
+extern int CmdPos;
+extern int skip_flag;
+
+static char Lines[MAX_LINES][BUFFER_SIZE];
+static int NoLines;
+
+
+/**
+ *  \fn         Args(int pops, int names, int quoted, int pushes)
+ *  \brief      What a GUI or peripheral word does to the stack and the input, without the GUI
+ *
+ *  \param[in]  pops     cells taken off the stack
+ *  \param[in]  names    words read from the input
+ *  \param[in]  quoted   how many of them are quoted strings, these come first
+ *  \param[in]  pushes   1 if the word leaves a success flag
+ */
+
+static void Args(int pops, int names, int quoted, int pushes) {
+    char name[BUFFER_SIZE];
+    int cond, i;
+
+    for (i=0; i<pops; i++) {
+        PopDs(&cond);
+    }
+    for (i=0; i<names; i++) {
+        skip_flag = i < quoted;
+        Word(name, sizeof(name));
+        skip_flag = 0;
+    }
+    if (pushes) {
+        ErrorCond(FORTH_TRUE);
+    }
+}
+
+static void Nop(void)         { }
+static void Pop1(void)        { Args(1, 0, 0, 0); }
+static void Pop2(void)        { Args(2, 0, 0, 0); }
+static void StubSetBar(void)  { Args(2, 0, 0, 1); }
+static void StubSetClr(void)  { Args(3, 0, 0, 1); }
+static void StubBtn(void)     { Args(3, 3, 2, 1); }
+static void StubPBar(void)    { Args(3, 1, 1, 1); }
+static void StubStTxt(void)   { Args(5, 2, 2, 1); }
+static void StubBmp(void)     { Args(3, 2, 2, 1); }
+
+
+/**
+ *  \fn         AddIoWords(void)
+ *  \brief      Defines the stand-ins of the GUI and peripheral words used by the scripts of ForthScripts/
+ */
+
+static void AddIoWords(void) {
+    AddDicEntry("ML",         FORTH_WORD_INBUILT,                    &Nop,         NULL, 0);
+    AddDicEntry("SHOW",       FORTH_WORD_INBUILT,                    &Nop,         NULL, 0);
+    AddDicEntry("CLR_GUI",    FORTH_WORD_INBUILT,                    &Nop,         NULL, 0);
+    AddDicEntry("EXIT_ML",    FORTH_WORD_INBUILT,                    &Nop,         NULL, 0);
+    AddDicEntry("SET_ST_TXT", FORTH_WORD_INBUILT,                    &Pop1,        NULL, 0);
+    AddDicEntry("SET_BMP",    FORTH_WORD_INBUILT,                    &Pop1,        NULL, 0);
+    AddDicEntry("DIGITALOUT", FORTH_WORD_INBUILT,                    &Pop2,        NULL, 0);
+    AddDicEntry("SET_P_BAR",  FORTH_WORD_INBUILT,                    &StubSetBar,  NULL, 0);
+    AddDicEntry("SET_ST_CLR", FORTH_WORD_INBUILT,                    &StubSetClr,  NULL, 0);
+    AddDicEntry("CRT_BTN",    FORTH_WORD_INBUILT | FORTH_WORD_ALONE, &StubBtn,     NULL, 0);
+    AddDicEntry("CRT_P_BAR",  FORTH_WORD_INBUILT | FORTH_WORD_ALONE, &StubPBar,    NULL, 0);
+    AddDicEntry("CRT_ST_TXT", FORTH_WORD_INBUILT | FORTH_WORD_ALONE, &StubStTxt,   NULL, 0);
+    AddDicEntry("CRT_BMP",    FORTH_WORD_INBUILT | FORTH_WORD_ALONE, &StubBmp,     NULL, 0);
+}
+
+
+/**
+ *  \fn         RunLine(char* line)
+ *  \brief      Interprets one line as if it had been typed in
+ */
+
+static int RunLine(char* line) {
+    int res = CONTINUE_FORTH_INTERPRET;
+
+    strcpy(CmdBuff, line);
+    RESET_CMDPOS;
+    while (!IS_EOL(CmdBuff[CmdPos])) {
+        res = Interpret();
+        if (res == COMPILE_ERROR || res == STOP_FORTH_INTERPRET) {
+            break;
+        }
+    }
+    RESET_CMDPOS;
+    return res;
+}
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+/**
+ *  \fn         TimePasses(int passes)
+ *  \brief      Returns the nanoseconds one pass over the script takes
+ */
+
+static double TimePasses(int passes) {
+    double start;
+    int i, j;
+
+    start = Now();
+    for (i=0; i<passes; i++) {
+        RunLine("MARKER COMPILE-PASS");
+        for (j=0; j<NoLines; j++) {
+            RunLine(Lines[j]);
+        }
+        RunLine("COMPILE-PASS");
+    }
+    return (Now() - start) / passes;
+}
+
+int main(int argc, char** argv) {
+    char* path = argc > 1 ? argv[1] : (char*)"../ForthScripts/ha.fs";
+    int passes = argc > 2 ? atoi(argv[2]) : DEF_PASSES;
+    double ns, best = 0;
+    FILE *fp, *rep;
+    int i, depth;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        printf ("%s not found\n", path);
+        return 1;
+    }
+    while (NoLines < MAX_LINES && fgets(Lines[NoLines], BUFFER_SIZE, fp) != NULL) {
+        NoLines++;
+    }
+    fclose(fp);
+
+    init_dictionary();
+    RESET_CMDPOS;
+    AddIoWords();
+
+    rep = fdopen(dup(fileno(stdout)), "w");     // the VM prints to stdout, which is silenced
+    fflush(stdout);
+    if (rep == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        return 1;
+    }
+
+    depth = DatStackTop;
+    TimePasses(1);                              // warms up, and checks the script leaves the stack as it was
+    if (DatStackTop != depth) {
+        fprintf (rep, "%s leaves %d cells on the stack\n", path, DatStackTop - depth);
+        return 1;
+    }
+    for (i=0; i<ROUNDS; i++) {
+        ns = TimePasses(passes);
+        if (i == 0 || ns < best) {
+            best = ns;
+        }
+    }
+
+    fprintf (rep, "%s: %d lines, %.1f us per pass, %.1f ns per line\n", path, NoLines, best / 1000, best / NoLines);
+    return 0;
+}
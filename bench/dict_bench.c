@@ -0,0 +1,125 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file     dict_bench.c
+ * \brief    Times dictionary lookups with 10, 100 and 1000 words defined
+ *
+ *           The hashed Find() is compared against the plain walk down the LATEST->next list which it
+ *           replaced. Both hits and misses are timed, a miss being what a number which does not start
+ *           with a digit pays before ParseNumber() is tried. This runs on the host, it is linked against
+ *           the forth library of the CMake build:
+ *
+ *           cmake --build build --target bench-dict
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "CoreForth.h"
+#include "interprter.h"
+
+#define BENCH_ROUNDS     200000          /**< Lookups timed for every dictionary size */
+#define BENCH_MAX_WORDS  1000            /**< Largest dictionary size */
+
+void DelLatestEntries(int no);
+
+char names[BENCH_MAX_WORDS][FORTH_NAMEMAX];
+char* misses[] = { "0", "1", "10", "255", "-1", "1000" };
+
+void Nop(void) {
+}
+
+/**
+ * The old lookup, kept here as the reference
+ */
+
+int LinearFind(char* name, cell* addr) {
+    int len = strlen(name);
+    NodePtr temp = LATEST;
+
+    while (temp != NULL) {
+        if (temp->WrdLen == len) {
+            if (strcmp(temp->WrdName, name) == 0) {
+                *addr = (cell)temp;
+                return FORTH_WORD_FOUND;
+            }
+        }
+        temp = temp->next;
+    }
+    return FORTH_WORD_NOT_FOUND;
+}
+
+double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Returns ns per lookup, half of the lookups hit and half miss
+ */
+
+double TimeLookups(int (*find)(char*, cell*), int words) {
+    int i, found = 0;
+    cell addr;
+    int nmiss = sizeof(misses)/sizeof(misses[0]);
+    double start;
+
+    start = Now();
+    for (i=0; i<BENCH_ROUNDS; i++) {
+        if (i & 1) {
+            found += find(names[(i >> 1) % words], &addr) == FORTH_WORD_FOUND;
+        } else {
+            found += find(misses[(i >> 1) % nmiss], &addr) == FORTH_WORD_FOUND;
+        }
+    }
+
+    if (found != BENCH_ROUNDS/2) {
+        printf ("lookup mismatch: %d found\n", found);
+    }
+    return (Now() - start) / BENCH_ROUNDS;
+}
+
+int main(void) {
+    int sizes[] = { 10, 100, 1000 };
+    int i, j, defined = 0;
+
+    for (i=0; i<BENCH_MAX_WORDS; i++) {
+        sprintf(names[i], "WORD-%d", i);
+    }
+
+    printf ("%8s %14s %14s\n", "words", "hashed ns", "linear ns");
+
+    for (i=0; i<3; i++) {
+        for (j=defined; j<sizes[i]; j++) {
+            AddDicEntry(names[j], FORTH_WORD_INBUILT, &Nop, NULL, 0);
+        }
+        defined = sizes[i];
+        printf ("%8d %14.1f %14.1f\n", defined, TimeLookups(&Find, defined), TimeLookups(&LinearFind, defined));
+    }
+
+    DelLatestEntries(defined);
+    return 0;
+}
@@ -0,0 +1,169 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file     dispatch_bench.c
+ * \brief    Compares the dispatch cost of the core words in Execute() against calling them through Node::func
+ *
+ *           Every pattern is compiled into a user word and executed with the primitives dispatched inside the
+ *           inner interpreter, then again with \a Node::prim cleared so that every word goes through its
+ *           function pointer the way all of them used to. The functions are the ones from forthFunctions.cpp.
+ *           This runs on the host, it is linked against the forth library of the CMake build:
+ *
+ *           cmake --build build --target bench-dispatch
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CoreForth.h"
+#include "interprter.h"
+#include "stack.h"
+#include "forthFunctions.h"
+
+#define BENCH_UNROLL     64              /**< Copies of the pattern in the benchmarked word */
+#define BENCH_ROUNDS     20000           /**< Executions of the benchmarked word */
+
+cell flag;                              /**< variable read by the "flag @ 0 =" pattern */
+
+struct BenchPrim {
+    char* name;
+    func_ptr func;
+    int prim;
+    cell xt;
+};
+
+struct BenchPrim prims[] = {
+    { "LIT", &Lit, PRIM_LIT, 0 },
+    { "0BRANCH", &CondBranch, PRIM_0BRANCH, 0 },
+    { "BRANCH", &UnCondBranch, PRIM_BRANCH, 0 },
+    { "+", &Add, PRIM_ADD, 0 },
+    { "*", &Mul, PRIM_MUL, 0 },
+    { "@", &Read, PRIM_FETCH, 0 },
+    { "=", &Equal, PRIM_EQ, 0 },
+    { "DUP", &Dup, PRIM_DUP, 0 },
+    { "DROP", &Drop, PRIM_DROP, 0 },
+    { "SWAP", &Swap, PRIM_SWAP, 0 },
+    { "OVER", &Over, PRIM_OVER, 0 },
+};
+
+#define NPRIMS   (sizeof(prims)/sizeof(prims[0]))
+
+/**
+ * Patterns are written as names, a number stands for an inline operand and "&FLAG" for the address of flag
+ */
+
+struct BenchPattern {
+    char* text;
+    int words;                          /**< dispatches per copy of the pattern */
+    char* cells[8];
+};
+
+struct BenchPattern patterns[] = {
+    { "DUP DROP",        2, { "DUP", "DROP", NULL } },
+    { "DUP +",           2, { "DUP", "+", NULL } },
+    { "DUP *",           2, { "DUP", "*", NULL } },
+    { "flag @ 0 = DROP", 5, { "LIT", "&FLAG", "@", "LIT", "0", "=", "DROP", NULL } },
+    { "SWAP",            1, { "SWAP", NULL } },
+    { "OVER DROP",       2, { "OVER", "DROP", NULL } },
+    { "LIT 1 DROP",      2, { "LIT", "1", "DROP", NULL } },
+    { "BRANCH 1",        1, { "BRANCH", "1", NULL } },
+    { "LIT 1 0BRANCH 1", 2, { "LIT", "1", "0BRANCH", "1" } },
+};
+
+cell code[BENCH_UNROLL*8];
+
+cell CellOf(char* name) {
+    unsigned int i;
+
+    for (i=0; i<NPRIMS; i++) {
+        if (strcmp(prims[i].name, name) == 0) {
+            return prims[i].xt;
+        }
+    }
+    if (strcmp(name, "&FLAG") == 0) {
+        return (cell)&flag;
+    }
+    return atoi(name);
+}
+
+void SetDispatch(int inline_prims) {
+    unsigned int i;
+
+    for (i=0; i<NPRIMS; i++) {
+        ((NodePtr)prims[i].xt)->prim = inline_prims ? prims[i].prim : PRIM_NONE;
+    }
+}
+
+double TimeWord(cell xt, int words) {
+    struct timespec t0, t1;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i=0; i<BENCH_ROUNDS; i++) {
+        Execute(xt);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ((double)BENCH_ROUNDS * BENCH_UNROLL * words);
+}
+
+int main(void) {
+    unsigned int i, j, k, len;
+    int cond;
+    cell xt;
+    double fp, inl;
+
+    for (i=0; i<NPRIMS; i++) {
+        AddDicEntry(prims[i].name, FORTH_WORD_INBUILT, prims[i].func, NULL, 0);    // in RAM, SetDispatch() writes it
+        LATEST->prim = prims[i].prim;
+        prims[i].xt = (cell)LATEST;
+    }
+
+    PushDs(0, &cond);
+    PushDs(0, &cond);
+
+    printf ("%-18s %12s %12s %8s\n", "pattern", "func ns", "prim ns", "speedup");
+
+    for (i=0; i<sizeof(patterns)/sizeof(patterns[0]); i++) {
+        len = 0;
+        for (j=0; j<BENCH_UNROLL; j++) {
+            for (k=0; k<8 && patterns[i].cells[k] != NULL; k++) {
+                code[len++] = CellOf(patterns[i].cells[k]);
+            }
+        }
+        AddDicEntry("BENCH", FORTH_WORD_USER, NULL, code, len);
+        xt = (cell)LATEST;
+
+        SetDispatch(FALSE);
+        fp = TimeWord(xt, patterns[i].words);
+        SetDispatch(TRUE);
+        inl = TimeWord(xt, patterns[i].words);
+
+        printf ("%-18s %12.2f %12.2f %7.2fx\n", patterns[i].text, fp, inl, fp/inl);
+    }
+
+    return 0;
+}
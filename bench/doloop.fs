@@ -0,0 +1,5 @@
+\ Nested DO/LOOP, 1000 passes of an empty inner loop of 100; loops.fs
+\ does the same with BEGIN/UNTIL and the counters on the stack
+\ expect: 1000
+
+: bench ( -- n ) 0 1000 0 do 100 0 do loop 1 + loop ;
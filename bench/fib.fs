@@ -0,0 +1,7 @@
+\ Fibonacci numbers by the usual double recursion, fib(22)
+\ expect: 17711
+
+: fib ( n -- fib[n] )
+  dup 1 > if dup 1 - recurse swap 2 - recurse + then ;
+
+: bench ( -- n ) 22 fib ;
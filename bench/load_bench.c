@@ -0,0 +1,167 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file     load_bench.c
+ * \brief    Times loading a large generated script with FLOAD, the throughput of the outer interpreter
+ *
+ *           Usage: forth-load-bench [-n lines] [-k]
+ *
+ *           A script of -n lines (50000 by default) is written to a temporary file and loaded with
+ *           ExecFromFile() three times, the best load counts. The script is made of blocks of ten lines which
+ *           define a few words and a variable, run a loop at the prompt, carry comments and numbers in every
+ *           base and are then forgotten through a marker, so that the dictionary does not fill up however
+ *           long the script is. This is far more than fits on the board, it is meant for stress testing and
+ *           profiling the lexer and the compiler. -k keeps the script and prints its name.
+ *
+ *           Everything the VM prints goes to /dev/null, the report goes to the original stdout. The host build
+ *           maps the script into memory, cmake -DFORTH_MMAP_SCRIPTS=OFF reads it a sector at a time the way
+ *           the board does.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "forthFunctions.h"
+#include "interprter.h"
+#include "stack.h"
+#include "CoreForth.h"
+#include "utils.h"
+#include "forth_files.h"
+
+#define ROUNDS           3              /**< Loads timed, the best one counts */
+#define DEF_LINES        50000          /**< Default length of the script */
+#define BLOCK_LINES      10             /**< Lines of one block of the script */
+
+extern int CmdPos;
+
+static const char* Block[BLOCK_LINES] = {
+    "MARKER LB-BLOCK",
+    "\\ block %d: definitions, a variable and a loop run at the prompt, forgotten at the end",
+    "VARIABLE acc  0 acc !",
+    ": sq ( n -- n*n ) dup * ;",
+    ": cube ( n -- n^3 ) dup sq * ;",
+    ": accum ( n -- ) acc @ + acc ! ;",
+    "10 0 DO I cube accum LOOP",
+    ": check ( -- f ) acc @ 2025 = IF 1 ELSE 0 THEN ;",
+    "check drop $ff %1010 + #12 + drop %d drop",
+    "LB-BLOCK",
+};
+
+
+/**
+ *  \fn         WriteScript(char* path, int lines)
+ *  \brief      Writes the script, \a lines rounded up to whole blocks
+ *
+ *  \return     bytes written, 0 if the file could not be written
+ */
+
+static long WriteScript(char* path, int lines) {
+    FILE* fp;
+    int i;
+    long bytes = 0;
+
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        return 0;
+    }
+    for (i=0; i<lines; i++) {
+        bytes += fprintf(fp, Block[i % BLOCK_LINES], i / BLOCK_LINES);
+        bytes += fprintf(fp, "\n");
+    }
+    fclose(fp);
+    return bytes;
+}
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+    char path[] = "/tmp/forth-load-XXXXXX";
+    int lines = DEF_LINES, keep = 0;
+    int i, fd, res, depth;
+    long bytes;
+    double start, ns, best = 0;
+    FILE* rep;
+
+    while ((i = getopt(argc, argv, "n:k")) != -1) {
+        switch (i) {
+        case 'n': lines = atoi(optarg); break;
+        case 'k': keep = 1; break;
+        default:
+            printf ("usage: %s [-n lines] [-k]\n", argv[0]);
+            return 1;
+        }
+    }
+    lines = (lines + BLOCK_LINES - 1) / BLOCK_LINES * BLOCK_LINES;
+
+    fd = mkstemp(path);
+    if (fd < 0) {
+        printf ("Could not create a temporary file\n");
+        return 1;
+    }
+    close(fd);
+    bytes = WriteScript(path, lines);
+    if (bytes == 0) {
+        printf ("Could not write %s\n", path);
+        return 1;
+    }
+
+    init_dictionary();
+    RESET_CMDPOS;
+
+    rep = fdopen(dup(fileno(stdout)), "w");     // the VM prints to stdout, which is silenced
+    fflush(stdout);
+    if (rep == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        return 1;
+    }
+
+    depth = DatStackTop;
+    for (i=0; i<ROUNDS; i++) {
+        start = Now();
+        res = ExecFromFile(path);
+        ns = Now() - start;
+        if (res != EXECUTION_COMPLETE || DatStackTop != depth) {
+            fprintf (rep, "loading %s failed\n", path);
+            return 1;
+        }
+        if (i == 0 || ns < best) {
+            best = ns;
+        }
+    }
+
+    fprintf (rep, "%d lines, %ld bytes: %.2f ms per load, %.0f ns per line, %.1f MB/s\n",
+             lines, bytes, best / 1e6, best / lines, bytes * 1e3 / best);
+    if (keep) {
+        fprintf (rep, "script kept in %s\n", path);
+    } else {
+        unlink(path);
+    }
+    return 0;
+}
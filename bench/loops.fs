@@ -0,0 +1,6 @@
+\ Nested BEGIN/UNTIL loops with the counters on the stack, 1000 passes of
+\ an empty inner loop of 100
+\ expect: 1000
+
+: bench ( -- n )
+  0 begin 0 begin 1 + dup 100 = until drop 1 + dup 1000 = until ;
@@ -0,0 +1,50 @@
+\ Runs the benchmarks on the board. Copy the scripts of this directory to
+\ the SD card and FLOAD RUN.FS, every benchmark prints the CPU cycles one
+\ BENCH took and the value it left (see the expect line of the script).
+
+: report ( n t0 -- ) cycles swap - . ." cycles, result " . cr ;
+
+marker (bench-mark)
+fload fib.fs
+cycles bench swap report
+(bench-mark)
+
+marker (bench-mark)
+fload sieve.fs
+cycles bench swap report
+(bench-mark)
+
+marker (bench-mark)
+fload bubble.fs
+cycles bench swap report
+(bench-mark)
+
+marker (bench-mark)
+fload loops.fs
+cycles bench swap report
+(bench-mark)
+
+marker (bench-mark)
+fload doloop.fs
+cycles bench swap report
+(bench-mark)
+
+marker (bench-mark)
+fload case4.fs
+cycles bench swap report
+(bench-mark)
+
+marker (bench-mark)
+fload case16.fs
+cycles bench swap report
+(bench-mark)
+
+marker (bench-mark)
+fload vars.fs
+cycles bench swap report
+(bench-mark)
+
+marker (bench-mark)
+fload strings.fs
+cycles bench swap report
+(bench-mark)
@@ -0,0 +1,22 @@
+\ Sieve of Eratosthenes, the classic BYTE benchmark: counts the primes
+\ among the odd numbers 3 .. 16383 with one byte flag each
+\ expect: 1899
+
+variable flags  here flags ! 8191 allot
+variable si  variable sk  variable sp  variable scnt
+
+: sinit ( -- ) 0 si ! begin 1 flags @ si @ + c! si @ 1 + dup si ! 8191 = until ;
+
+: smark ( -- )
+  si @ dup + 3 + sp !  si @ sp @ + sk !
+  sk @ 8191 < if
+    begin 0 flags @ sk @ + c! sk @ sp @ + dup sk ! 8190 > until
+  then ;
+
+: bench ( -- n )
+  0 scnt ! sinit 0 si !
+  begin
+    flags @ si @ + c@ if smark scnt @ 1 + scnt ! then
+    si @ 1 + dup si ! 8191 =
+  until
+  scnt @ ;
@@ -0,0 +1,12 @@
+\ String output, 100 lines of text and numbers
+\ expect: 100
+
+variable sn
+
+: bench ( -- n )
+  0 sn !
+  begin
+    ." The quick brown fox jumps over the lazy dog " sn @ . cr
+    sn @ 1 + dup sn ! 100 =
+  until
+  sn @ ;
@@ -0,0 +1,12 @@
+\ Variable heavy loop, every step reads and writes several variables
+\ expect: 50005000
+
+variable va  variable vb  variable vc  variable vn
+
+: bench ( -- n )
+  0 va ! 0 vb ! 0 vc ! 0 vn !
+  begin
+    va @ 1 + va !  vb @ va @ + vb !  vc @ vb @ xor vc !
+    vn @ 1 + dup vn ! 10000 =
+  until
+  vb @ ;
@@ -0,0 +1,103 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       host_io.c
+ * \brief      Host side of the board specific hooks
+ *
+ *             The host has no GUI, touch screen or peripherals. The words of forthIO.cpp are left out and the hooks
+ *             the core calls into do nothing.
+ *
+ */
+
+#include <time.h>
+#include "forthFunctions.h"
+#include "CoreForth.h"
+#include "ts.h"
+
+
+/**
+ * No GUI or peripheral words on the host, see IoDic
+ */
+
+const struct Node* const IoDic = NULL;
+const int IoWords = 0;
+
+
+/**
+ *
+ * \fn         DropIoCallbacks(void)
+ * \brief      No buttons hold execution tokens on the host
+ *
+ */
+
+void DropIoCallbacks(void) {
+}
+
+
+/**
+ *
+ * \fn         ReadCycles(void)
+ * \brief      There is no portable cycle counter, the host counts nanoseconds of the monotonic clock instead
+ *
+ */
+
+ucell ReadCycles(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ucell)ts.tv_sec * 1000000000u + (ucell)ts.tv_nsec;
+}
+
+
+/**
+ *
+ * \fn         stop_TS(void)
+ * \brief      No touch screen shares the bus with the files on the host
+ *
+ */
+
+void stop_TS(void) {
+}
+
+
+/**
+ *
+ * \fn         start_TS(void)
+ * \brief      See stop_TS()
+ *
+ */
+
+void start_TS(void) {
+}
+
+
+/**
+ *
+ * \fn         FlushConsole(void)
+ * \brief      stdout of the host is flushed by FLUSH itself, there is no ring to wait for
+ *
+ */
+
+void FlushConsole(void) {
+}
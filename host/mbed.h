@@ -0,0 +1,120 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       mbed.h
+ * \brief      Stand in for the parts of the mbed SDK the Forth VM uses, for the host build
+ *
+ *             Serial goes to stdin/stdout, DigitalOut only remembers its value, wait() sleeps and Ticker runs its
+ *             callback from SIGALRM. There is a single interval timer per process, so only one Ticker can be
+ *             attached at a time, which is all ADDTICKER needs.
+ *
+ */
+
+#ifndef __HOST_MBED_H
+#define __HOST_MBED_H
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+typedef int PinName;                        /**< Pins only name things on the host */
+
+#define LED1      0
+#define USBTX     1
+#define USBRX     2
+
+/**
+ * \class       Serial
+ * \brief       Console, reads stdin and writes stdout
+ */
+
+class Serial {
+public:
+    Serial(PinName tx, PinName rx) {}
+    int readable(void) { return 1; }
+    int getc(void) { return getchar(); }
+    int putc(int c) { return putchar(c); }
+};
+
+/**
+ * \class       DigitalOut
+ * \brief       Output pin, keeps the last value written
+ */
+
+class DigitalOut {
+public:
+    DigitalOut(PinName pin) : value(0) {}
+    DigitalOut& operator= (int v) { value = v; return *this; }
+    operator int() { return value; }
+private:
+    int value;
+};
+
+/**
+ * \class       Ticker
+ * \brief       Calls a function periodically, from a signal handler like the interrupt it stands in for
+ */
+
+class Ticker {
+public:
+    void attach(void (*fptr)(void), float t) {
+        struct itimerval it;
+
+        Handler() = fptr;
+        signal(SIGALRM, &Ticker::Alarm);
+        it.it_interval.tv_sec = (long)t;
+        it.it_interval.tv_usec = (long)((t - (long)t) * 1000000);
+        if (it.it_interval.tv_sec == 0 && it.it_interval.tv_usec == 0) {
+            it.it_interval.tv_usec = 1;
+        }
+        it.it_value = it.it_interval;
+        setitimer(ITIMER_REAL, &it, NULL);
+    }
+
+    void detach(void) {
+        struct itimerval it = {{0, 0}, {0, 0}};
+
+        setitimer(ITIMER_REAL, &it, NULL);
+        Handler() = NULL;
+    }
+
+private:
+    static void (*&Handler(void))(void) {
+        static void (*handler)(void);
+        return handler;
+    }
+
+    static void Alarm(int sig) {
+        if (Handler() != NULL) {
+            Handler()();
+        }
+    }
+};
+
+inline void wait(float s) { usleep((useconds_t)(s * 1000000)); }
+inline void wait_ms(int ms) { usleep(ms * 1000); }
+inline void wait_us(int us) { usleep(us); }
+
+#endif
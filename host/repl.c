@@ -0,0 +1,88 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       repl.c
+ * \brief      Forth VM for the host, a read-eval-print loop on the console
+ *
+ *             Usage: forth-repl [-i image script] [script ...]
+ *
+ *             The scripts are loaded in order, like FLOAD would, before reading lines from stdin. Scripts are
+ *             looked up relative to the current directory. The REPL ends at the end of input.
+ *
+ *             -i starts up the way the board does when its init file names an image: the image saved after
+ *             loading script is loaded instead of the script, which is loaded if the image is out of date.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "forthFunctions.h"
+#include "interprter.h"
+#include "utils.h"
+#include "forth_files.h"
+#include "image.h"
+
+extern int CmdPos;
+
+
+int main(int argc, char** argv) {
+    int i, res;
+
+    init_dictionary();
+    RESET_CMDPOS;
+
+    i = 1;
+    if (argc > 3 && strcmp(argv[1], "-i") == 0) {
+        if (LoadImageFile(argv[2], argv[3]) != IMAGE_OK && ExecFromFile(argv[3]) == FILE_NOT_FOUND) {
+            return 1;
+        }
+        i = 4;
+    }
+
+    for ( ; i<argc; i++) {
+        if (ExecFromFile(argv[i]) == FILE_NOT_FOUND) {
+            return 1;
+        }
+    }
+
+    while (fgets(CmdBuff, BUFFER_SIZE, stdin) != NULL) {
+
+        res = CONTINUE_FORTH_INTERPRET;
+
+        while (!IS_EOL(CmdBuff[CmdPos])) {
+            res = Interpret();
+            if (res == COMPILE_ERROR || res == STOP_FORTH_INTERPRET ) {
+                break;
+            }
+        }
+
+        RESET_CMDPOS;
+        if ( res != CONTINUE_FORTH_COMPILE) {
+            printf (" OK \n");
+        }
+        ServiceTicker();                // ticker words due while we waited for input
+    }
+
+    return 0;
+}
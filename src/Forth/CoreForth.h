@@ -30,6 +30,8 @@
 #ifndef __LINKED_LIST_H
 #define __LINKED_LIST_H
 
+#include "types.h"
+
 
 #define NODE_ADDING_ERROR     2             /**< Error code to return when there is no more memory to create words */
 #define NODE_ADDING_SUCCESS   0             /**< Return code if node (dictionory entry) was created successfully */
@@ -41,11 +43,33 @@
 
 #define SIZE                  150             /**< General purpouse size define */
 
+#define FORTH_HASH_SIZE       64              /**< Number of buckets in the dictionary hash index, must be a power of 2 */
+#define ROM_WORDS_MAX         255             /**< Most inbuilt words, their hash index holds them in a byte */
+
+#ifndef FORTH_ARENA_CELLS
+#define FORTH_ARENA_CELLS     4096            /**< Size of the dictionary arena in cells, holds every entry with its code and data */
+#endif
+
+#ifndef FORTH_PROFILE
+#define FORTH_PROFILE         0               /**< 1 builds in the profiler, PROFILE-ON, PROFILE-OFF and .PROFILE */
+#endif
+
+#ifndef FORTH_TOKEN_CODE
+#define FORTH_TOKEN_CODE      0               /**< 1 packs the code of finished words into 16 bit tokens, see token.c */
+#endif
+
+#if defined(TARGET_LPC1768)
+#define FORTH_ARENA_SECTION   __attribute__((section("AHBSRAM0"), aligned))  /**< Arena gets the 16 KB AHB bank, keeps the heap free */
+#else
+#define FORTH_ARENA_SECTION
+#endif
+
 #define bool    char                         /**< Boolean type */
 #define TRUE    1                            /**< True condition */
 #define FALSE   0                            /**< False Condition */
 
 #define FORTH_WORD_DEL      2                /**< Code for indicating word was deleted successfully */
+#define FORTH_WORD_PROTECTED 3               /**< Code for indicating the word is inbuilt and cannot be deleted */
 
 #define _BV(bit)(1 << bit)                   /**< Sets a bit position */
 #define WORD_INBUILT         1               /**< Inbuilt word */
@@ -55,13 +79,57 @@
 #define WORD_USER           3                /**< Bit position for user defined flag */
 #define FORTH_WORD_USER    _BV(WORD_USER)    /**< Flag for indicating user defined word */
 #define COMPILE_ONLY        4                /**< Bit position for \a FORTH_COMPILE_ONLY */
-#define FORTH_COMPILE_ONLY _BV(COMPILE_ONLY) /**< Function can be executed only in compile mode */
+#define FORTH_COMPILE_ONLY _BV(COMPILE_ONLY) /**< Function can be executed only while a definition or a line is compiled */
 #define VAR                    5                /**< Bit position for \a FORTH_WORD_VAR */
 #define FORTH_WORD_VAR     _BV(VAR) /**< Word has a variable to which memory has been allocated */
+#define VERIFIED            6                /**< Bit position for \a FORTH_WORD_VERIFIED */
+#define FORTH_WORD_VERIFIED _BV(VERIFIED)    /**< Stack effect proven, the code uses unchecked primitives, see VerifyWord() */
+#define WORD_INLINE         7                /**< Bit position for \a FORTH_WORD_INLINE */
+#define FORTH_WORD_INLINE  _BV(WORD_INLINE)  /**< INLINE, the code is copied into the words calling it whatever its size */
+#define WORD_NOINLINE       8                /**< Bit position for \a FORTH_WORD_NOINLINE */
+#define FORTH_WORD_NOINLINE _BV(WORD_NOINLINE) /**< NOINLINE, the word is always called */
+#define WORD_PURE           9                /**< Bit position for \a FORTH_WORD_PURE */
+#define FORTH_WORD_PURE    _BV(WORD_PURE)    /**< Result depends on the arguments only, the compiler folds it over literals */
+#define WORD_ALONE         10                /**< Bit position for \a FORTH_WORD_ALONE */
+#define FORTH_WORD_ALONE   _BV(WORD_ALONE)   /**< Reads the rest of the line or changes the dictionary, a line is run up to it first */
 
 
 #define END_WORD            -55               /**< YOU CANNOT USE THIS CONSTANT IN FORTH PROGRAM. IF YOU USE IT FORTH WILL CRASH */
 
+#if FORTH_TOKEN_CODE
+typedef uint16_t code_unit;                   /**< Unit of finished code, a token, a branch offset or part of a cell */
+#define END_CODE            0                 /**< Token ending the code of a finished word */
+#define TOKEN_WORD          0x100             /**< Token of the entry at DicArena[0], the inbuilt words are the ones below */
+#if FORTH_ARENA_CELLS > 0x10000 - TOKEN_WORD
+#error "16 bit tokens reach 65280 cells of arena, lower FORTH_ARENA_CELLS"
+#endif
+#else
+typedef cell code_unit;                       /**< Unit of finished code, the address of an entry or an operand */
+#define END_CODE            END_WORD          /**< Ends the code of a word */
+#endif
+
+#define CELL_UNITS          ((int)(sizeof(cell) / sizeof(code_unit)))   /**< Units of code a cell operand takes */
+
+#include "words.h"
+
+/**
+ * \enum        forth_prim
+ * \brief       Primitives which the inner interpreter executes itself instead of calling \a Node::func, see
+ *              FORTH_PRIMS in words.h
+ */
+
+#define PRIM_ENUM(id, name, func, flags, in, out, checks)   PRIM_##id,
+
+enum forth_prim {
+    PRIM_NONE,                                       /**< Not a primitive, call func or nest into the code */
+    FORTH_PRIMS(PRIM_ENUM)
+    PRIM_COUNT                                       /**< Number of primitives, not a primitive */
+};
+
+#define PRIM_UNCHECKED(p)   ((p) + PRIM_COUNT)       /**< Variant of primitive p which leaves out the stack checks */
+#define PRIM_BASE(p)        ((p) % PRIM_COUNT)       /**< Primitive an unchecked variant belongs to */
+
+#define STK_UNKNOWN         -1                       /**< Node::StkIn of a word whose stack effect is not known */
 
 /// can hold address of a node. struct node* is 'typedef'ed as NodePtr
 typedef struct Node* NodePtr ;
@@ -69,6 +137,20 @@ typedef struct Node* NodePtr ;
 /// func_ptr holds pointer to functions of type void func(void)
 typedef void(*func_ptr)(void);
 
+#if FORTH_PROFILE
+/**
+ * \struct      ProfCount
+ * \brief       What the profiler counts for a word, see profile.c
+ */
+
+struct ProfCount {
+    unsigned long calls;                            /**< Executions since PROFILE-ON */
+    unsigned long long incl;                        /**< Ticks spent in the word and everything it called */
+    unsigned long long excl;                        /**< Ticks spent in the word itself */
+    int active;                                     /**< Activations being timed, only the outermost adds to incl */
+};
+#endif
+
 /**
  * \struct      Node
  * \brief       Structure for handling FORTH dictionary.
@@ -80,10 +162,18 @@ typedef void(*func_ptr)(void);
 struct Node {
     char WrdName[FORTH_NAMEMAX];                    /**< Holds the word name */
     int flag;                                        /**< To hold various conditions such as FORTH_WORD, FORTH_INBUILT etc */
-    int *code;                                       /**< Array to hold the address of various code word */
+    cell *code;                                      /**< Array to hold the address of various code word, tokens with FORTH_TOKEN_CODE */
     NodePtr next;                                    /**< To point to next entry in the dictionary */
     int WrdLen;                                     /**< length of word name */
     func_ptr func;                                  /**< Function pointer to inbuilt function */
+    NodePtr hnext;                                  /**< To point to next entry in the same hash bucket */
+    int prim;                                       /**< One of \a forth_prim, PRIM_NONE if func has to be called */
+    signed char StkIn;                              /**< Cells the word takes from the data stack, or STK_UNKNOWN */
+    signed char StkOut;                             /**< Cells it leaves in their place */
+    signed char StkPeak;                            /**< Most cells it has on the stack above the depth it was called at */
+#if FORTH_PROFILE
+    struct ProfCount prof;                          /**< Profile of a user word, profile.c keeps those of the inbuilt ones */
+#endif
 };
 
 
@@ -98,7 +188,55 @@ struct Buffer {
     char flag;
 };
 
-int AddDicEntry(char* name, int ForthFlags, func_ptr func, int* CodeList, int len);
+int AddDicEntry(char* name, int ForthFlags, func_ptr func, cell* CodeList, int len);
+int IndexRomWords(void);
+cell* StartDicEntry(char* name, int ForthFlags);
+int EndDicEntry(int len);
+void AbortDicEntry(void);
+NodePtr PendingEntry(void);
+int DicRoom(void);
+char* DicAllot(int bytes);
+int DicComma(cell val);
+int ForgetFrom(NodePtr node);
+void ProtectDictionary(void);
+void AppendDicEntries(NodePtr latest, char* end);
+
+void ShrinkDicEntry(char* end);
+
+extern NodePtr LATEST;
+extern NodePtr const PrimNode[2*PRIM_COUNT];
+extern const struct Node RomDic[];
+extern const int RomWords;
+extern const struct Node* const IoDic;
+extern const int IoWords;
+extern cell DicArena[FORTH_ARENA_CELLS];
+extern char* DicHere;
+extern char* DicFence;
+
+
+/**
+ * \fn          RomNode(int i)
+ * \brief       Returns inbuilt word \a i, the words of \a RomDic come first and those of \a IoDic after them
+ */
+
+static inline NodePtr RomNode(int i) {
+    return (NodePtr)(i < RomWords ? &RomDic[i] : &IoDic[i - RomWords]);
+}
+
+/**
+ * \fn          RomIndex(NodePtr node)
+ * \brief       Inverse of RomNode(), -1 for an entry in the arena
+ */
+
+static inline int RomIndex(NodePtr node) {
+    if (node >= RomDic && node < RomDic + RomWords) {
+        return node - RomDic;
+    }
+    if (node >= IoDic && node < IoDic + IoWords) {
+        return RomWords + (node - IoDic);
+    }
+    return -1;
+}
 
 #endif
 
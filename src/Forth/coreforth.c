@@ -32,17 +32,320 @@
 #include <stdlib.h>
 #include <string.h>
 #include "CoreForth.h"
+#include "types.h"
+#include "utils.h"
 
 
 NodePtr LATEST;                       /**< Always holds address of the latest entry to the dictionary */
 NodePtr FIRST;                        /**< Always holds the address of the first entry in the dictionary */
+NodePtr DicHash[FORTH_HASH_SIZE];     /**< Hash index over the dictionary, each bucket holds the latest entry first */
+static unsigned char RomHash[FORTH_HASH_SIZE];  /**< Hash index over the inbuilt words, 1 + RomNode() index of the first of a bucket, 0 if empty */
+static unsigned char RomChain[ROM_WORDS_MAX];   /**< Next inbuilt word of the same bucket, same encoding */
+
+FORTH_ARENA_SECTION
+cell DicArena[FORTH_ARENA_CELLS];     /**< All dictionary entries, their code and data live here */
+char* DicHere = (char*)DicArena;      /**< Next free byte in the arena, HERE in Forth */
+char* DicFence = (char*)DicArena;     /**< Entries below this cannot be forgotten */
+static char* EntryEnd = (char*)DicArena; /**< End of the latest entry, ALLOT cannot give back space below it */
+static NodePtr Pending;               /**< Entry being compiled, not yet linked into the dictionary */
 
 
 /* In terms of Linked list standard defination Latest is the head, first is the tail */
 
+
+/**
+ *
+ * \fn        HashName(const char* name, int len)
+ * \brief     Computes the hash bucket of a word name
+ *
+ *            Names are hashed the way they are stored in the dictionary, i.e converted to upper case, so that a
+ *            name read from the input can be looked up as it is.
+ *
+ * \param[in] name  name of the word, not necessarily ended by a NUL
+ * \param[in] len   length of the name
+ *
+ * \return    index of the bucket in \a DicHash
+ *
+ */
+
+static unsigned int HashName(const char* name, int len) {
+    unsigned int hash = 5381;
+    int i;
+
+    for (i=0; i<len; i++) {
+        hash = (hash << 5) + hash + (unsigned char)TO_UPPER(name[i]);  // hash * 33 + c
+    }
+
+    return hash & (FORTH_HASH_SIZE - 1);
+}
+
+/**
+ *
+ * \fn        SameName(const char* stored, const char* name, int len)
+ * \brief     Compares the name of an entry against a name of \a len characters read from the input, in any case
+ *
+ */
+
+static int SameName(const char* stored, const char* name, int len) {
+    int i;
+
+    for (i=0; i<len; i++) {
+        if (stored[i] != TO_UPPER(name[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ *
+ * \fn        DicAlign(int size)
+ * \brief     Aligns \a DicHere to a multiple of size
+ *
+ */
+
+static void DicAlign(int size) {
+    DicHere = (char*)(((ucell)DicHere + size - 1) & ~(ucell)(size - 1));
+}
+
+
+/**
+ *
+ * \fn        DicRoom(void)
+ * \brief     Returns the number of free bytes left in the dictionary arena
+ *
+ */
+
+int DicRoom(void) {
+    return (char*)&DicArena[FORTH_ARENA_CELLS] - DicHere;
+}
+
+
 /**
  *
- * \fn        AddDicEntry(char* name, int ForthFlags, func_ptr func, int* CodeList, int len)
+ * \fn        DicAllot(int bytes)
+ * \brief     Reserves space at the end of the dictionary, ALLOT in Forth
+ *
+ *            A negative count gives space back, but never below the last dictionary entry.
+ *
+ * \param[in] bytes  number of bytes to reserve
+ *
+ * \return    Address of the reserved space or NULL if the arena is full
+ *
+ */
+
+char* DicAllot(int bytes) {
+    char* addr = DicHere;
+
+    if (bytes > DicRoom()) {
+        return NULL;
+    }
+    if (bytes < 0 && DicHere + bytes < EntryEnd) {
+        return NULL;
+    }
+    DicHere += bytes;
+
+    return addr;
+}
+
+
+/**
+ *
+ * \fn        DicComma(cell val)
+ * \brief     Aligns \a DicHere and appends a cell to the dictionary, , in Forth
+ *
+ * \return    NODE_ADDING_SUCCESS or NODE_ADDING_ERROR if the arena is full
+ *
+ */
+
+int DicComma(cell val) {
+    cell* addr;
+
+    DicAlign(sizeof(cell));
+    addr = (cell*)DicAllot(sizeof(cell));
+    if (addr == NULL) {
+        return NODE_ADDING_ERROR;
+    }
+    *addr = val;
+
+    return NODE_ADDING_SUCCESS;
+}
+
+
+/**
+ *
+ * \fn        StartDicEntry(char* name, int ForthFlags)
+ * \brief     Starts a new dictionary entry at \a DicHere
+ *
+ *            The header is placed at the aligned \a DicHere and the code of the word follows it directly, the
+ *            compiler writes the code right there. The entry is not visible to Find() and \a DicHere is not
+ *            moved until EndDicEntry() is called, so an abandoned definition needs no clean up.
+ *
+ * \param[in] name          name of the word
+ * \param[in] ForthFlags    flags to indicate various attributes of a word
+ *
+ * \return    Where the code of the word goes or NULL if the arena is full
+ *
+ */
+
+cell* StartDicEntry(char* name, int ForthFlags) {
+    NodePtr mid;
+    int i;
+
+    DicAlign(sizeof(NodePtr));
+    if (DicRoom() < (int)sizeof(struct Node) + (int)sizeof(cell)) {
+#ifdef DEBUG
+        printf ("\nCould not allocate memory \n");
+#endif
+        Pending = NULL;
+        return NULL;
+    }
+
+    mid = (NodePtr)DicHere;
+    for (i=0; i<FORTH_NAMEMAX-1 && name[i] != '\0'; i++) {
+        mid->WrdName[i] = TO_UPPER(name[i]);    // names are stored in upper case, see FindName()
+    }
+    mid->WrdName[i] = '\0';
+    mid->WrdLen = i;
+    mid->flag = ForthFlags;
+    mid->prim = PRIM_NONE;
+    mid->StkIn = STK_UNKNOWN;
+    mid->StkOut = mid->StkPeak = 0;
+    mid->func = NULL;
+    mid->code = (cell*)(mid + 1);
+#if FORTH_PROFILE
+    memset(&mid->prof, 0, sizeof(mid->prof));
+#endif
+    Pending = mid;
+
+    return mid->code;
+}
+
+
+/**
+ *
+ * \fn        EndDicEntry(int len)
+ * \brief     Finishes the entry started by StartDicEntry() and links it into the dictionary
+ *
+ * \param[in] len   number of code cells written, END_WORD is appended here
+ *
+ * \return    NODE_ADDING_SUCCESS or NODE_ADDING_ERROR if the code did not fit
+ *
+ */
+
+int EndDicEntry(int len) {
+    NodePtr mid = Pending;
+    unsigned int bucket;
+
+    Pending = NULL;
+    if (mid == NULL || (char*)&mid->code[len+1] > (char*)&DicArena[FORTH_ARENA_CELLS]) {
+        return NODE_ADDING_ERROR;
+    }
+    mid->code[len] = END_WORD;                  // to indicate end of code word
+    EntryEnd = DicHere = (char*)&mid->code[len+1];
+
+    bucket = HashName(mid->WrdName, mid->WrdLen);
+    mid->hnext = DicHash[bucket];               // latest entry goes first so that redefinitions shadow the old ones
+    DicHash[bucket] = mid;
+
+    if (LATEST == NULL) {                   // first entry ever
+        FIRST = mid;
+    }
+    mid->next = LATEST;
+    LATEST = mid;
+
+    return NODE_ADDING_SUCCESS;
+}
+
+
+/**
+ *
+ * \fn        PendingEntry(void)
+ * \brief     Returns the entry started by StartDicEntry() and not finished yet, NULL if there is none
+ *
+ */
+
+NodePtr PendingEntry(void) {
+    return Pending;
+}
+
+
+/**
+ *
+ * \fn        AbortDicEntry(void)
+ * \brief     Abandons the entry started by StartDicEntry()
+ *
+ */
+
+void AbortDicEntry(void) {
+    Pending = NULL;
+}
+
+
+/**
+ *
+ * \fn        ShrinkDicEntry(char* end)
+ * \brief     Gives back the space past \a end of the latest entry, whose code was packed into less, see EncodeWord()
+ *
+ *            Nothing is given back once something was appended to the entry, \a DicHere stays aligned to a cell.
+ *
+ */
+
+void ShrinkDicEntry(char* end) {
+    char* here = DicHere;
+
+    DicHere = end;
+    DicAlign(sizeof(cell));
+    if (DicHere < EntryEnd && EntryEnd == here) {
+        EntryEnd = DicHere;
+    } else {
+        DicHere = here;
+    }
+}
+
+
+/**
+ *
+ * \fn        AppendDicEntries(NodePtr latest, char* end)
+ * \brief     Links entries which were copied into the arena at \a DicHere, e.g from a saved image
+ *
+ *            The entries are walked from \a latest down to the current \a LATEST. Every entry goes into its
+ *            hash bucket after the newer ones of the same batch and before everything that was already there.
+ *
+ * \param[in] latest  newest of the copied entries, its chain has to end at the current \a LATEST
+ * \param[in] end     first free byte after the copied entries
+ *
+ */
+
+void AppendDicEntries(NodePtr latest, char* end) {
+    static NodePtr* tail[FORTH_HASH_SIZE];
+    NodePtr mid, oldest = NULL;
+    unsigned int bucket;
+    int i;
+
+    for (i=0; i<FORTH_HASH_SIZE; i++) {
+        tail[i] = &DicHash[i];
+    }
+
+    for (mid = latest; mid != NULL && (char*)mid >= DicHere; mid = mid->next) {
+        bucket = HashName(mid->WrdName, mid->WrdLen);
+        mid->hnext = *tail[bucket];
+        *tail[bucket] = mid;
+        tail[bucket] = &mid->hnext;
+        oldest = mid;
+    }
+
+    if (FIRST == NULL) {
+        FIRST = oldest;
+    }
+    LATEST = latest;
+    EntryEnd = DicHere = end;
+}
+
+
+/**
+ *
+ * \fn        AddDicEntry(char* name, int ForthFlags, func_ptr func, cell* CodeList, int len)
  * \brief     Adds a Word to dictionary
  *
  *            This function adds a word from front into the dictionary
@@ -62,55 +365,69 @@ NodePtr FIRST;                        /**< Always holds the address of the first
  *
  */
 
-int AddDicEntry(char* name, int ForthFlags, func_ptr func, int* CodeList, int len) {
-    NodePtr mid;                    // for our node processing purpouses
+int AddDicEntry(char* name, int ForthFlags, func_ptr func, cell* CodeList, int len) {
+    cell* code;
     int i;
 
-    mid = (NodePtr)malloc(sizeof(struct Node));
-
-    if (mid == NULL) {
-#ifdef DEBUG
-        printf ("\nCould not allocate memory \n");
-#endif
+    code = StartDicEntry(name, ForthFlags);
+    if (code == NULL) {
         return NODE_ADDING_ERROR;
     }
 
-    strcpy(mid->WrdName, name);
-    mid->WrdLen = strlen(name);                 // store name and length
+    if ((char*)&code[len+1] > (char*)&DicArena[FORTH_ARENA_CELLS]) {
+        AbortDicEntry();
+        return NODE_ADDING_ERROR;
+    }
 
-    if (LATEST == NULL) {                   // first entry ever
-        LATEST = mid;
-        mid->next = NULL;
-        FIRST = mid;
+    for (i=0; i<len; i++) {
+        code[i] = CodeList[i];              // store the addresses of words that this word is composed of
+    }
 
-    } else {
-        mid->next = LATEST;
-        LATEST = mid;
+    if (EndDicEntry(len) != NODE_ADDING_SUCCESS) {
+        return NODE_ADDING_ERROR;
     }
+    LATEST->func = func;
 
-    /* we have added the nodes as required now is the time to do set up the environment for each word */
+    return NODE_ADDING_SUCCESS;
 
-    mid->flag = ForthFlags;
-    // first let us add function handler
-    if (mid->flag & FORTH_WORD_INBUILT) {
-        mid->func = func;
-    } else {
-        if (len == 0) {
-            mid->code[0] = 0;
-            mid->code[1] = END_WORD;
-            return NODE_ADDING_SUCCESS;             // if list is empty create a list and leave (empty entry)
-        }
+}
+
+
+/**
+ *
+ * \fn        IndexRomWords(void)
+ * \brief     Builds the hash index over the inbuilt words, which live in ROM and cannot be chained themselves
+ *
+ *            The words of a bucket are chained in table order, no name is listed twice.
+ *
+ * \return    NODE_ADDING_SUCCESS or NODE_ADDING_ERROR if there are more than ROM_WORDS_MAX inbuilt words
+ *
+ */
+
+int IndexRomWords(void) {
+    unsigned char* tail[FORTH_HASH_SIZE];
+    unsigned int bucket;
+    int i;
+
+    if (RomWords + IoWords > ROM_WORDS_MAX) {
+        return NODE_ADDING_ERROR;
+    }
 
-        // else
-        mid->code = (int*)malloc((len+1)*sizeof(int));
-        for (i=0; i<len; i++) {
-            mid->code[i] = CodeList[i];              // store the addresses of words that this word is composed of
+    for (i=0; i<FORTH_HASH_SIZE; i++) {
+        RomHash[i] = 0;
+        tail[i] = &RomHash[i];
+    }
+    for (i=0; i<RomWords + IoWords; i++) {
+        if (RomNode(i)->WrdLen == 0) {      // the unused rows of the primitives
+            continue;
         }
-        mid->code[i] = END_WORD;                             // to indicate end of code word
+        bucket = HashName(RomNode(i)->WrdName, RomNode(i)->WrdLen);
+        RomChain[i] = 0;
+        *tail[bucket] = i + 1;
+        tail[bucket] = &RomChain[i];
     }
 
     return NODE_ADDING_SUCCESS;
-
 }
 
 
@@ -124,6 +441,7 @@ int AddDicEntry(char* name, int ForthFlags, func_ptr func, int* CodeList, int le
 
 void DisplayDic(void) {
     NodePtr temp;
+    int i;
     temp = LATEST;
 
     while (temp != NULL) {
@@ -131,98 +449,138 @@ void DisplayDic(void) {
         printf ("length   : %d\n", temp->WrdLen);
         temp = temp->next;
     }
+    for (i=0; i<RomWords + IoWords; i++) {
+        if (RomNode(i)->WrdLen != 0) {
+            printf ("Name     : %s\n", RomNode(i)->WrdName);
+            printf ("length   : %d\n", RomNode(i)->WrdLen);
+        }
+    }
 }
 
 /**
- * \fn              Find(char* name, int* addr)
+ * \fn              FindName(const char* name, int len, cell* addr)
  * \brief           Finds a dictionary entry with given name
  *
  *                  This function serches for a word with given name if it finds the word then returns FORTH_WORD_FOUND
- *                  else returns FOTH_WORD_NOT_FOUND
+ *                  else returns FOTH_WORD_NOT_FOUND. Only the hash bucket of the name is walked, most recent
+ *                  definition first, so the cost does not grow with the size of the dictionary. The inbuilt
+ *                  words are looked up after the user dictionary, so they can be redefined.
+ *
+ *                  The name is looked up right where it was read in the input buffer: it need not end with a
+ *                  NUL and upper and lower case are the same.
  *
  * \param[in]       name name of the word
+ * \param[in]       len  its length
  * \param[out]      addr address at which the entry was found
  * \return          FORTH_WORD_FOUND  If the word was found  \n
  *                  FORTH_WORD_NOT_FOUN if the word was not found in the dictnory
  *
  */
 
-int Find(char* name, int* addr) {
-    int len = strlen(name);
-    NodePtr temp = LATEST;                     // start with the latest entry
-
+int FindName(const char* name, int len, cell* addr) {
+    int i;
+    unsigned int bucket;
+    NodePtr temp;
 
-    while (temp != NULL) {
+    bucket = HashName(name, len);
 
-        if (temp->WrdLen == len) {            // name matching speed up thingy
-            if (strcmp(temp->WrdName, name) == 0) {
-                *addr = (int)temp;
-                return FORTH_WORD_FOUND;
-            }
+    for (temp = DicHash[bucket]; temp != NULL; temp = temp->hnext) {    // latest entry in the bucket first
+        if (temp->WrdLen == len && SameName(temp->WrdName, name, len)) {
+            *addr = (cell)temp;
+            return FORTH_WORD_FOUND;
         }
+    }
 
-        temp = temp->next;
+    for (i = RomHash[bucket]; i != 0; i = RomChain[i-1]) {
+        temp = RomNode(i-1);
+        if (temp->WrdLen == len && SameName(temp->WrdName, name, len)) {
+            *addr = (cell)temp;
+            return FORTH_WORD_FOUND;
+        }
     }
 
-    addr = NULL;
     return FORTH_WORD_NOT_FOUND;
 }
 
+/**
+ * \fn              Find(char* name, cell* addr)
+ * \brief           Finds a dictionary entry with given name, a string ending with a NUL, see FindName()
+ */
+
+int Find(char* name, cell* addr) {
+    return FindName(name, strlen(name), addr);
+}
+
+/**
+ *
+ * \fn             ForgetFrom(NodePtr node)
+ * \brief          Removes an entry and everything defined after it from the dictionary
+ *
+ *                 The arena is handed back by moving \a DicHere down to the entry. Later entries sit at higher
+ *                 addresses and every hash bucket holds the newest entries first, so only the bucket heads have
+ *                 to be trimmed.
+ *
+ * \param[in]      node  oldest entry to be removed
+ *
+ * \return         FORTH_WORD_DEL or FORTH_WORD_PROTECTED if the entry cannot be removed
+ *
+ */
+
+int ForgetFrom(NodePtr node) {
+    int i;
+
+    if ((char*)node < DicFence || (char*)node >= DicHere) {
+        return FORTH_WORD_PROTECTED;
+    }
+
+    for (i=0; i<FORTH_HASH_SIZE; i++) {
+        while (DicHash[i] != NULL && DicHash[i] >= node) {
+            DicHash[i] = DicHash[i]->hnext;
+        }
+    }
+
+    LATEST = node->next;
+    EntryEnd = DicHere = (char*)node;
+
+    return FORTH_WORD_DEL;
+}
+
+/**
+ *
+ * \fn             ProtectDictionary(void)
+ * \brief          Everything in the dictionary so far can no longer be forgotten
+ *
+ */
+
+void ProtectDictionary(void) {
+    DicFence = DicHere;
+}
+
 /**
  *
  * \fn             DelDicEntry(char* name)
  * \brief          This function deletes a dictionary entry.
  *                 This function searches for a dictionary entry with given name. If it finds one it deletes the entry
- *                 and returns FORTH_WORD_DEL or else FORTH_WORD_NOT_FOUND
+ *                 along with every entry defined after it and returns FORTH_WORD_DEL or else FORTH_WORD_NOT_FOUND
  * \param[in]      name name of the dictionary entry to be deleted
  * \return         FORTH_WORD_DEL if word was found and deleted \n
- *                 FORTH_WORD_NOT_FOUND if word could not be found
+ *                 FORTH_WORD_NOT_FOUND if word could not be found \n
+ *                 FORTH_WORD_PROTECTED if the word is inbuilt
  *
  */
 
 int DelDicEntry(char *name) {
-    int len = strlen(name), *x;
-    NodePtr temp, temp1;
-    temp = LATEST;           // start with head, find the most recent entry with given name
-
+    cell addr;
 
-    if (strcmp(temp->WrdName, name) == 0 || strcmp(name, "LATEST")==0) {
-        LATEST = temp->next;
-        if (temp->flag & FORTH_WORD_VAR) {
-            x = (int*) temp->code[1];
-            free(x);                            // free memory allocated for the variable
-        }
-        free(temp->code);
-        free(temp);
-        return FORTH_WORD_DEL;
+    if (strcmp(name, "LATEST") == 0) {
+        return LATEST == NULL ? FORTH_WORD_NOT_FOUND : ForgetFrom(LATEST);
     }
 
-    while (temp != NULL) {
-        temp1 = temp->next;
-        if (temp1 != NULL) {
-            if (temp1->WrdLen == len) {
-                if (strcmp(temp1->WrdName, name) == 0) {
-                    break;                 // found the word
-                }
-            }
-            temp = temp->next;
-        }
+    if (Find(name, &addr) == FORTH_WORD_NOT_FOUND) {
+        return FORTH_WORD_NOT_FOUND;
     }
 
-    if (temp != NULL) {
-        // do these things only if word was found
-        temp1 = temp->next;
-        temp->next = temp->next->next;
-        if (temp1->flag & FORTH_WORD_VAR) {
-            x = (int*)  temp1->code[1];
-            free(x);
-        }
-        free(temp1->code);                 // free memory allocated for the code
-        free(temp1);
-        return FORTH_WORD_DEL;
-    }
-
-    return FORTH_WORD_NOT_FOUND;
+    return ForgetFrom((NodePtr)addr);
 }
 
 /**
@@ -233,24 +591,17 @@ int DelDicEntry(char *name) {
  */
 
 void DelLatestEntries(int no) {
-    int i, *x;
-    NodePtr temp ,temp1;
+    int i;
+    NodePtr temp;
     temp = LATEST;
-    if (0 == no) {
+    if (0 == no || temp == NULL) {
         return ;
     }
 
-    for (i=0; i<no; i++) {
-        LATEST = temp->next;
-        if (temp->flag & FORTH_WORD_VAR) {
-            x = (int*) temp->code[1];
-            free(x);                            // free memory allocated for the variable
-        }
-        temp1 = temp->next;
-        free(temp->code);
-        free(temp);
-        temp = temp1;
+    for (i=1; i<no && temp->next != NULL; i++) {
+        temp = temp->next;
     }
+    ForgetFrom(temp);
 }
 
 
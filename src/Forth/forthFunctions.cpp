@@ -25,7 +25,8 @@
  * \file       forthFunctions.c
  * \brief      This file contains functions which implement basic Forth words.
  *
- *             All the c functions that will be identified with a word are defined in this file
+ *             All the c functions that will be identified with a word are defined in this file, except for
+ *             the words driving the GUI and the peripherals of the board which are in forthIO.cpp
  *
  */
 
@@ -40,21 +41,15 @@
 #include "stack.h"
 #include "CoreForth.h"
 #include "types.h"
-#include "gui.h"
 #include "utils.h"
 #include "forth_files.h"
+#include "optimise.h"
+#include "image.h"
+#include "profile.h"
+#include "token.h"
 
 
 
-#define  GEN_SIZE         20
-
-#define  INSUFF_PARAMS    0
-#define  GUI_NOT_FOUND    1
-#define  INVALID_PORT     2
-#define  COULD_NOT_FIND_FILE 3
-#define  COULD_NOT_ADD_GUI   4
-
-
 
 const char ERR_TABLE[][50] = { "\nInsufficient number of parameters ",
                                "\nCould not find GUI element with id ",
@@ -65,79 +60,57 @@ const char ERR_TABLE[][50] = { "\nInsufficient number of parameters ",
 
 
 
+/**
+ * The inbuilt words, see words.h. They are never written to, so the table stays in flash on the board. The
+ * primitives come first, entry p of the table is primitive p and entry PRIM_UNCHECKED(p) its unchecked variant,
+ * which is named after it with a leading ~ and which VerifyWord() compiles into words whose stack use it has
+ * proven. Entries 0 and PRIM_COUNT are not used.
+ */
+
+const struct Node RomDic[] = {
+    ROM_ROW("", NULL, 0, PRIM_NONE, STK_UNKNOWN, 0)
+    FORTH_PRIMS(ROM_PRIM)
+    ROM_ROW("", NULL, 0, PRIM_NONE, STK_UNKNOWN, 0)
+    FORTH_PRIMS(ROM_UNCHECKED)
+    FORTH_WORDS(ROM_WORD)
+};
+
+const int RomWords = sizeof(RomDic) / sizeof(RomDic[0]);
+
+#define PRIM_NODE(id, name, func, flags, in, out, checks)       (NodePtr)&RomDic[PRIM_##id],
+#define UNCHECKED_NODE(id, name, func, flags, in, out, checks)  \
+    (checks) ? (NodePtr)&RomDic[PRIM_UNCHECKED(PRIM_##id)] : (NodePtr)NULL,
+
+/**
+ * Entry of every primitive and its unchecked variant, used by the compiler to emit them. NULL for the primitives
+ * which check nothing and have no unchecked variant to be compiled.
+ */
+
+NodePtr const PrimNode[2*PRIM_COUNT] = {
+    NULL,
+    FORTH_PRIMS(PRIM_NODE)
+    NULL,
+    FORTH_PRIMS(UNCHECKED_NODE)
+};
+
+
 /**
 *
 * \fn        init_dictionary(void)
-* \brief     Builds the dictionary
+* \brief     Indexes the inbuilt words, the dictionary of the user starts out empty
 *
 * \return    0 on success 1 on error
 *
 */
 
+
 int init_dictionary(void) {
-    AddDicEntry(":", FORTH_WORD_INBUILT, &ColonFunc, NULL, 0);
-    AddDicEntry("+", FORTH_WORD_INBUILT, &Add, NULL, 0);
-    AddDicEntry("-", FORTH_WORD_INBUILT, &Sub, NULL, 0);
-    AddDicEntry("*", FORTH_WORD_INBUILT, &Mul, NULL, 0);
-    AddDicEntry("/", FORTH_WORD_INBUILT, &Div, NULL, 0);
-    AddDicEntry(".", FORTH_WORD_INBUILT, &Dot, NULL, 0);
-    AddDicEntry(".S", FORTH_WORD_INBUILT, &DotS, NULL, 0);
-    AddDicEntry("LIT", FORTH_WORD_INBUILT, &Lit, NULL, 0);
-    AddDicEntry("SWAP", FORTH_WORD_INBUILT, &Swap, NULL, 0);
-    AddDicEntry("DUP", FORTH_WORD_INBUILT, &Dup, NULL, 0);
-    AddDicEntry("OVER", FORTH_WORD_INBUILT, &Over, NULL, 0);
-    AddDicEntry("DROP", FORTH_WORD_INBUILT, &Drop, NULL, 0);
-    AddDicEntry("BASE", FORTH_WORD_INBUILT, &BaseSet, NULL, 0);
-    AddDicEntry("EXIT", FORTH_WORD_INBUILT, &Exit, NULL, 0);
-    AddDicEntry("VARIABLE", FORTH_WORD_INBUILT, &Create, NULL, 0);
-    AddDicEntry("@", FORTH_WORD_INBUILT, &Read, NULL, 0);
-    AddDicEntry("!", FORTH_WORD_INBUILT, &Write, NULL, 0);
-    AddDicEntry("?BASE", FORTH_WORD_INBUILT, &QueryBase, NULL, 0);
-    AddDicEntry("0BRANCH", FORTH_WORD_INBUILT, &CondBranch, NULL, 0);
-    AddDicEntry("BRANCH", FORTH_WORD_INBUILT, &UnCondBranch, NULL, 0);
-    AddDicEntry("IF", FORTH_WORD_INBUILT | FORTH_WORD_IMED | FORTH_COMPILE_ONLY , &If, NULL, 0);
-    AddDicEntry("THEN", FORTH_WORD_INBUILT | FORTH_WORD_IMED| FORTH_COMPILE_ONLY, &Then, NULL, 0);
-    AddDicEntry("ELSE", FORTH_WORD_INBUILT | FORTH_WORD_IMED | FORTH_COMPILE_ONLY, &Else, NULL, 0);
-    AddDicEntry("BEGIN", FORTH_WORD_INBUILT | FORTH_WORD_IMED | FORTH_COMPILE_ONLY, &Begin, NULL, 0);
-    AddDicEntry("UNTIL", FORTH_WORD_INBUILT | FORTH_WORD_IMED | FORTH_COMPILE_ONLY, &Until, NULL, 0);
-    AddDicEntry("=", FORTH_WORD_INBUILT, &Equal, NULL, 0);
-    AddDicEntry("<", FORTH_WORD_INBUILT, &LT, NULL, 0);
-    AddDicEntry(">", FORTH_WORD_INBUILT, &GT, NULL, 0);
-    AddDicEntry("<=", FORTH_WORD_INBUILT, &LTE, NULL, 0);
-    AddDicEntry(">=", FORTH_WORD_INBUILT, &Equal, NULL, 0);
-    AddDicEntry(";", FORTH_WORD_INBUILT | FORTH_WORD_IMED, &StopCompile, NULL, 0);
-    AddDicEntry("STR", FORTH_WORD_INBUILT, &DispStr, NULL, 0);
-    AddDicEntry(".\"", FORTH_WORD_INBUILT | FORTH_WORD_IMED | FORTH_COMPILE_ONLY, &DotStr, NULL, 0);
-    AddDicEntry("\\", FORTH_WORD_INBUILT | FORTH_WORD_IMED , &SkipComment1, NULL, 0);
-    AddDicEntry("(", FORTH_WORD_INBUILT | FORTH_WORD_IMED , &SkipComment2, NULL, 0);
-    AddDicEntry("NOT", FORTH_WORD_INBUILT, &Not, NULL, 0);
-    AddDicEntry("AND", FORTH_WORD_INBUILT, &And, NULL, 0);
-    AddDicEntry("OR", FORTH_WORD_INBUILT, &Or, NULL, 0);
-    AddDicEntry("XOR", FORTH_WORD_INBUILT, &Xor, NULL, 0);
-    AddDicEntry("?BITSET", FORTH_WORD_INBUILT, &BitSet, NULL, 0);
-    AddDicEntry("?BITCLEAR", FORTH_WORD_INBUILT, &BitClear, NULL, 0);
-    AddDicEntry("CR", FORTH_WORD_INBUILT, &Cr, NULL, 0);
-
-
-    AddDicEntry("ML", FORTH_WORD_INBUILT, &MainLoop, NULL, 0);
-    AddDicEntry("ADDTICKER", FORTH_WORD_INBUILT, &AddTicker, NULL, 0);
-    AddDicEntry("CRT_BTN", FORTH_WORD_INBUILT, &CreateBtn, NULL, 0);
-    AddDicEntry("SHOW", FORTH_WORD_INBUILT, &ShowWidgets, NULL, 0);
-    AddDicEntry("CRT_P_BAR", FORTH_WORD_INBUILT, &CreatePBar, NULL, 0);
-    AddDicEntry("SET_P_BAR", FORTH_WORD_INBUILT, &SetPBar, NULL, 0);
-    AddDicEntry("CRT_ST_TXT", FORTH_WORD_INBUILT, &CreateStTxt, NULL, 0);
-    AddDicEntry("SET_ST_TXT", FORTH_WORD_INBUILT , &SetStTxt, NULL, 0);
-    AddDicEntry("SET_ST_CLR", FORTH_WORD_INBUILT , &SetStClr, NULL, 0);
-    AddDicEntry("DIGITALOUT", FORTH_WORD_INBUILT , &SetPort, NULL, 0);
-    AddDicEntry("DIGITALIN", FORTH_WORD_INBUILT , &ReadPort, NULL, 0);
-    AddDicEntry("ANALOGIN", FORTH_WORD_INBUILT , &AnalogRead, NULL, 0);
-    AddDicEntry("ANALOGOUT", FORTH_WORD_INBUILT , &AnalogWrite, NULL, 0);
-    AddDicEntry("EXIT_ML", FORTH_WORD_INBUILT , &ExitMainLoop, NULL, 0);
-    AddDicEntry("FLOAD", FORTH_WORD_INBUILT , &Fload, NULL, 0);
-    AddDicEntry("CRT_BMP", FORTH_WORD_INBUILT , &AddBmp, NULL, 0);
-    AddDicEntry("SET_BMP", FORTH_WORD_INBUILT , &SetBmp, NULL, 0);
-    AddDicEntry("CLR_GUI", FORTH_WORD_INBUILT , &ClearGui, NULL, 0);
-    AddDicEntry("SPIWRITE", FORTH_WORD_INBUILT , &SpiWrite, NULL, 0);
+    if (IndexRomWords() != NODE_ADDING_SUCCESS) {
+        printf ("\nToo many inbuilt words ");
+        return 1;
+    }
+
+    ProtectDictionary();                                 // the user dictionary starts here
     return 0;
 }
 /**
@@ -150,8 +123,10 @@ int init_dictionary(void) {
 
 
 extern bool CompileMode;
+extern bool CompileFailed;
 void ColonFunc(void) {
     CompileMode = TRUE;
+    StartDefinition();
 }
 
 
@@ -165,7 +140,8 @@ void ColonFunc(void) {
  */
 
 void Add(void) {
-    int cond, temp1, temp2;
+    int cond;
+    cell temp1, temp2;
 
     temp1 = PopDs(&cond) ;
     temp2 = PopDs(&cond);
@@ -191,7 +167,8 @@ void Add(void) {
  */
 
 void Sub(void) {
-    int cond, temp1, temp2;
+    int cond;
+    cell temp1, temp2;
 
     temp1 = PopDs(&cond) ;
     temp2 = PopDs(&cond);
@@ -237,41 +214,15 @@ void Exit(void) {
  *
  * \fn     Lit(void)
  * \brief  This function pushes a number into DS present within a compiled word
- * \note   Manipulates Return stack
+ * \note   The number is the cell at \a IP, which is skipped
  *
  */
 
-extern int i_pc;
-extern int CurrentAddr;
-extern int InitialAddr;
-
 void Lit(void) {
-    int temp, cond, Addr, tempi;
-    NodePtr CodePtr;
-
-    Addr = PopRs(&cond);         // take out the address
-    tempi = PopRs(&cond);
-
-
-
-    CodePtr = (NodePtr)Addr;
-
-
-    temp = CodePtr->code[tempi];  // read the number
-    //i_pc++;
-
-    PushDs(temp, &cond);      // Push the number onto stack
-
-    temp = CodePtr->code[tempi+1];
-
-    if (temp == END_WORD) return ; // look at Interpreter() function, we are not saving addresses if we are nearing
-    // end of the word. The interpreter is built with this logic let us use violate that
-
-    PushRs(tempi+1, &cond);   // store back the address so that interpreter can continue what it was doing
-    PushRs(Addr, &cond);      // after skipping the number (tempi+1)
-
-
+    int cond;
 
+    PushDs(CODE_CELL(IP), &cond);   // Push the number onto stack
+    IP += CELL_UNITS;               // and skip it
 }
 
 /**
@@ -282,12 +233,13 @@ void Lit(void) {
  */
 
 void Dot(void) {
-    int temp, cond;
+    cell temp;
+    int cond;
 
     temp = PopDs(&cond);
 
     if (cond != STACK_ERR_EMPTY) {
-        printf ("\n%d ", temp);
+        printf ("\n" CELL_FMT " ", temp);
     }
 }
 
@@ -300,7 +252,8 @@ void Dot(void) {
  */
 
 void Mul(void) {
-    int temp1, temp2, cond;
+    cell temp1, temp2;
+    int cond;
 
     temp1 = PopDs(&cond);
     temp2 = PopDs(&cond);
@@ -318,21 +271,24 @@ void Mul(void) {
 /**
  *
  *  \fn       Div(void)
- *  \brief    divide nos by tos and leaves the result on tos ( a b -- a/b ).
+ *  \brief    divide nos by tos and leaves the result on tos ( a b -- a/b ), 0 if b is 0.
  *
  */
 
 void Div(void) {
-    int temp1, temp2, cond;
+    cell temp1, temp2;
+    int cond;
 
     temp1 = PopDs(&cond);
     temp2 = PopDs(&cond);
 
-    if (cond == STACK_ERR_EMPTY || temp1 == 0) {
+    if (cond == STACK_ERR_EMPTY) {
         return ;
     }
 
-    temp1 = temp2/temp1;
+    if (temp1 != 0) {                   // division by zero gives 0, words verified with ( n n -- n ) rely on it
+        temp1 = temp2/temp1;
+    }
 
     PushDs(temp1, &cond);
 }
@@ -346,7 +302,8 @@ void Div(void) {
  */
 
 void Swap(void) {
-    int temp1, temp2, cond;
+    cell temp1, temp2;
+    int cond;
 
     temp1 = PopDs(&cond);
     temp2 = PopDs(&cond);
@@ -368,7 +325,8 @@ void Swap(void) {
  */
 
 void Dup(void) {
-    int temp, cond;
+    cell temp;
+    int cond;
 
     temp = PopDs(&cond);
 
@@ -400,7 +358,8 @@ void Drop(void) {
  */
 
 void Over(void) {
-    int temp1, temp2, cond;
+    cell temp1, temp2;
+    int cond;
 
     temp1 = PopDs(&cond);
     temp2 = PopDs(&cond);
@@ -425,7 +384,8 @@ void Over(void) {
 
 extern int BASE;
 void BaseSet(void) {
-    int temp, cond;
+    cell temp;
+    int cond;
 
     temp = PopDs(&cond);
 
@@ -443,25 +403,189 @@ void BaseSet(void) {
  *  \fn      Create(void)
  *  \brief   Creates a variable by given name and then allocates memory to it
  *
+ *           The variable is a cell in the dictionary right after the code of the word, FORGET gives it back.
  */
 
 void Create(void) {
-    int *addr;                            // to hold the address
-    int CodeArr[5];                       // to hold newely created word
-    char buff[10];                        // to hold variable name
-    int i=0;
-    Word(buff);                           // get the name
+    cell CodeArr[2];                      // to hold newely created word
+    char buff[SIZE];                      // to hold variable name
+
+    if (Word(buff, sizeof(buff)) == WORD_TOO_LONG) {   // get the name
+        return;
+    }
+    if (buff[0] == '\0') {
+        printf ("\nPlease specify a name for the variable ");
+        return;
+    }
+
+    CodeArr[0] = (cell)PrimNode[PRIM_LIT];
+    CodeArr[1] = 0;                       // address of the variable, patched below
+
+    if (AddDicEntry(buff, FORTH_WORD_USER | FORTH_WORD_VAR, NULL, CodeArr, 2) != NODE_ADDING_SUCCESS) {
+        printf ("\nDictionary full ");
+        return;
+    }
+    VerifyWord(LATEST, 2);
+    EncodeWord(LATEST, 2);
+    if (DicComma(0) != NODE_ADDING_SUCCESS) {
+        ForgetFrom(LATEST);
+        printf ("\nDictionary full ");
+        return;
+    }
+
+    PatchLit(LATEST, (cell)(DicHere - sizeof(cell)));
+}
+
+/**
+ *  \fn      Here(void)
+ *  \brief   Pushes the address of the next free byte in the dictionary ( -- addr )
+ */
+
+void Here(void) {
+    int cond;
+
+    PushDs((cell)DicHere, &cond);
+}
+
+/**
+ *  \fn      Allot(void)
+ *  \brief   Reserves n bytes at the end of the dictionary, negative n gives them back ( n -- )
+ */
+
+void Allot(void) {
+    cell temp;
+    int cond;
+
+    temp = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
+
+    if (DicAllot(temp) == NULL) {
+        printf ("\nDictionary full ");
+    }
+}
+
+/**
+ *  \fn      Comma(void)
+ *  \brief   Appends a cell to the dictionary ( x -- )
+ */
+
+void Comma(void) {
+    cell temp;
+    int cond;
+
+    temp = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
+
+    if (DicComma(temp) != NODE_ADDING_SUCCESS) {
+        printf ("\nDictionary full ");
+    }
+}
+
+/**
+ *  \fn      CComma(void)
+ *  \brief   Appends a byte to the dictionary ( c -- )
+ */
+
+void CComma(void) {
+    cell temp;
+    int cond;
+    char* addr;
+
+    temp = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
+
+    addr = DicAllot(1);
+    if (addr == NULL) {
+        printf ("\nDictionary full ");
+        return;
+    }
+    *addr = (char)temp;
+}
+
+/**
+ *  \fn      Forget(void)
+ *  \brief   Removes the given word and everything defined after it from the dictionary
+ */
+
+void Forget(void) {
+    char buff[SIZE];
+    cell TempAddr;
+
+    if (Word(buff, sizeof(buff)) == WORD_TOO_LONG) {
+        return;
+    }
+    ToUp(buff);
+
+    if (Find(buff, &TempAddr) == FORTH_WORD_NOT_FOUND) {
+        printf ("Word %s not found \n", buff);
+        return;
+    }
+
+    if (ForgetFrom((NodePtr)TempAddr) != FORTH_WORD_DEL) {
+        printf ("%s cannot be forgotten \n", buff);
+        return;
+    }
+    DropCallbacks();
+}
+
+/**
+ *  \fn      ForgetXt(void)
+ *  \brief   Forgets the dictionary entry found on TOS and everything after it, compiled by MARKER ( xt -- )
+ */
+
+void ForgetXt(void) {
+    cell temp;
+    int cond;
+
+    temp = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
+
+    ForgetFrom((NodePtr)temp);
+    DropCallbacks();
+}
+
+/**
+ *  \fn      Marker(void)
+ *  \brief   Defines a word which, when executed, forgets itself and everything defined after it
+ */
 
-    addr = (int*) malloc(sizeof(int));    // allocate memory
+void Marker(void) {
+    cell CodeArr[3];
+    char buff[SIZE];
+    cell TempAddr;
 
-    Find("LIT", &CodeArr[i]);
-    i++;
-    CodeArr[i] = (int)addr;
-    i++;
+    if (Word(buff, sizeof(buff)) == WORD_TOO_LONG) {
+        return;
+    }
+    if (buff[0] == '\0') {
+        printf ("\nPlease specify a name for the marker ");
+        return;
+    }
 
-    AddDicEntry(buff, FALSE, NULL, CodeArr, i);
+    CodeArr[0] = (cell)PrimNode[PRIM_LIT];
+    CodeArr[1] = 0;                       // the marker itself, patched below
+    Find("(FORGET)", &TempAddr);
+    CodeArr[2] = TempAddr;
 
+    if (AddDicEntry(buff, FORTH_WORD_USER | FORTH_WORD_ALONE, NULL, CodeArr, 3) != NODE_ADDING_SUCCESS) {
+        printf ("\nDictionary full ");
+        return;
+    }
+    EncodeWord(LATEST, 3);
 
+    PatchLit(LATEST, (cell)LATEST);
 }
 
 /**
@@ -470,7 +594,8 @@ void Create(void) {
  */
 
 void Read(void) {
-    int *TempAddr, temp, cond;
+    cell *TempAddr, temp;
+    int cond;
 
     temp = PopDs(&cond);
 
@@ -478,7 +603,7 @@ void Read(void) {
         return;
     }
 
-    TempAddr = (int*)temp;
+    TempAddr = (cell*)temp;
 
     // try and access memory if crashes nothing can be done
     temp = *TempAddr;
@@ -493,7 +618,8 @@ void Read(void) {
  */
 
 void Write (void) {
-    int *TempAddr, temp, cond;
+    cell *TempAddr, temp;
+    int cond;
 
     temp = PopDs(&cond);
 
@@ -501,7 +627,7 @@ void Write (void) {
         return ;
     }
 
-    TempAddr = (int*) temp;
+    TempAddr = (cell*) temp;
 
     temp = PopDs(&cond);            // read the data
 
@@ -512,6 +638,79 @@ void Write (void) {
     *TempAddr = temp;
 }
 
+/**
+ *  \fn       CFetch(void)
+ *  \brief    Reads the byte at the address found on TOS ( addr -- char )
+ */
+
+void CFetch(void) {
+    cell temp;
+    int cond;
+
+    temp = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
+
+    PushDs(*(unsigned char*)temp, &cond);
+}
+
+/**
+ *  \fn       CStore(void)
+ *  \brief    Writes the low byte of NOS to the address found on TOS ( char addr -- )
+ */
+
+void CStore(void) {
+    cell addr, temp;
+    int cond;
+
+    addr = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
+
+    temp = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
+
+    *(unsigned char*)addr = (unsigned char)temp;
+}
+
+/**
+ *  \fn       Cells(void)
+ *  \brief    Converts a number of cells into bytes, for ALLOT and address arithmetic ( n -- n*cellsize )
+ */
+
+void Cells(void) {
+    cell temp;
+    int cond;
+
+    temp = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
+
+    PushDs(temp * (cell)sizeof(cell), &cond);
+}
+
+/**
+ *  \fn       Cycles(void)
+ *  \brief    Pushes a free running tick count, CPU cycles on the board and nanoseconds on the host ( -- ticks )
+ *
+ *            Only the difference of two readings means anything, it wraps around on the board after about 44s.
+ */
+
+void Cycles(void) {
+    int cond;
+
+    PushDs((cell)ReadCycles(), &cond);
+}
+
 
 /**
  *   \fn      QueryBase
@@ -528,9 +727,8 @@ void QueryBase(void) {
  */
 
 void CondBranch(void) {
-    int temp, offset, tempi, cond, Addr;
-    NodePtr CodePtr;
-
+    cell temp;
+    int cond;
 
     temp = PopDs(&cond);
 
@@ -538,64 +736,119 @@ void CondBranch(void) {
         temp = 0;
     }
 
-    Addr = PopRs(&cond);         // take out the address
-    tempi = PopRs(&cond);
-
-    CodePtr = (NodePtr)Addr;
-    offset = CodePtr->code[tempi];  // read the number
-
     if (temp != 0) {
-        PushRs(tempi+1, &cond);   // store back the address so that interpreter can continue what it was doing
-        PushRs(Addr, &cond);      // after skipping the offset number
+        IP++;                     // skip the offset
     } else {
-        PushRs(tempi+offset, &cond);
-        PushRs(Addr, &cond);
+        IP += CODE_OFFSET(IP);    // offset is relative to the cell holding it
     }
 }
 
 
 /**
  *  \fn      UnCondBranch
- *  \brief   This a conditional branching instruction if tos is 0, false it continues or else branches to offset value
+ *  \brief   This an unconditional branching instruction, branches to offset value found at \a IP
  */
 
 void UnCondBranch(void) {
-    int offset, tempi, cond, Addr;
-    NodePtr CodePtr;
+    IP += CODE_OFFSET(IP);
+}
 
+/**
+ *  \fn       If(void)
+ *  \brief    This function implements if only to be used in compile mode
+ *
+ *            IF straight after a literal knows which arm will run. It compiles no branch and leaves ARM_LIVE or
+ *            ARM_DEAD() on the control stack instead of the offset to patch, the arm that never runs is compiled
+ *            and then dropped by ELSE or THEN.
+ */
 
-    Addr = PopRs(&cond);         // take out the address
-    tempi = PopRs(&cond);
+extern cell *CompileCode;
+extern int j_pc;
+extern int LitRun;
 
-    CodePtr = (NodePtr)Addr;
-    offset = CodePtr->code[tempi];  // read the number
+static void DropArm(int at);
 
-    /* Same as conditional branching but no condition checking */
-    PushRs(tempi+offset, &cond);
-    PushRs(Addr, &cond);
+/**
+ *  \fn       CompileFail(void)
+ *  \brief    Called by a control word which cannot compile, Interpret() drops the definition or the line
+ */
 
+static void CompileFail(void) {
+    CompileMode = FALSE;
+    CompileFailed = TRUE;
 }
 
 /**
- *  \fn       If(void)
- *  \brief    This function implements if only to be used in compile mode
+ *  \fn       PushControl(cell at, int tag)
+ *  \brief    Leaves a place in the code for the control word which closes the structure, see PopControl()
  *
+ *            While a word or a line is compiled the data stack belongs to the control words, Interpret() has put
+ *            the stack of the user aside. Every entry is tagged with the kind of structure which left it.
  */
 
-extern int CompileCode[];
-extern int j_pc;
+static void PushControl(cell at, int tag) {
+    int cond;
+
+    PushDs(at, &cond);
+    PushDs(tag, &cond);
+    if (cond == STACK_ERR_FULL) {
+        CompileFail();
+    }
+}
+
+/**
+ *  \fn       Innermost(int tag)
+ *  \brief    Tells if the innermost control structure open is of kind \a tag
+ */
+
+static int Innermost(int tag) {
+    return DatStackTop >= 2 && DatStack[DatStackTop-1] == tag;
+}
+
+/**
+ *  \fn       PopControl(int tag, int* at)
+ *  \brief    Takes back the place in the code left by PushControl()
+ *
+ *            Fails unless the innermost structure open is of kind \a tag and the place lies in the code compiled
+ *            so far. Only CTRL_ORIG may be ARM_LIVE or ARM_DEAD() instead.
+ *
+ *  \return   TRUE if \a at was set
+ */
+
+static int PopControl(int tag, int* at) {
+    cell temp;
+    int cond;
+
+    if (Innermost(tag) == FALSE) {
+        CompileFail();
+        return FALSE;
+    }
+    DatStackTop--;
+    temp = PopDs(&cond);
+    if (temp > j_pc || (temp < 0 && (tag != CTRL_ORIG || (temp != ARM_LIVE && ARM_DEAD(temp) > j_pc)))) {
+        CompileFail();
+        return FALSE;
+    }
+    *at = (int)temp;
+    return TRUE;
+}
 
 void If(void) {
-    int TempAddr, cond;
+    cell TempAddr;
+
+    if (j_pc - LitRun >= 2) {                  // the condition is a literal
+        j_pc -= 2;
+#if FORTH_FOLD_DEBUG
+        printf ("\nFolded %ld IF ", (long)CompileCode[j_pc+1]);
+#endif
+        PushControl(CompileCode[j_pc+1] ? ARM_LIVE : ARM_DEAD(j_pc), CTRL_ORIG);
+        return;
+    }
 
     Find("0BRANCH", &TempAddr);                // find the conditional branching instruction
     CompileCode[j_pc] = TempAddr;
     j_pc++;
-    PushDs(j_pc, &cond);                      // We are in compiled mode i guess it is safe to use data stack now for internal use
-    if (cond == STACK_ERR_FULL) {
-        CompileMode= FALSE;                   // stop compiling
-        return ;
-    }
+    PushControl(j_pc, CTRL_ORIG);             // patched by ELSE or THEN
     CompileCode[j_pc] = 0;                    // add dummy offset;
     j_pc++;
 
@@ -607,15 +860,19 @@ void If(void) {
  *  \brief     This function calculates the ofsett and stores it at the appropriate location
  */
 void Then(void) {
-    int offset, cond, temp;
+    int offset, temp;
 
-    temp = offset = PopDs(&cond);
-    if (cond == STACK_ERR_EMPTY) {
-        CompileMode= FALSE;
+    if (PopControl(CTRL_ORIG, &temp) == FALSE) {
+        return;
+    }
+    if (temp < 0) {                             // IF on a literal
+        if (temp != ARM_LIVE) {
+            DropArm(ARM_DEAD(temp));
+        }
         return;
     }
 
-    offset = j_pc - offset;                     // j_pc is at current location
+    offset = j_pc - temp;                       // j_pc is at current location
 
     CompileCode[temp] = offset;
 }
@@ -626,11 +883,17 @@ void Then(void) {
  */
 
 void Else(void) {
-    int offset, cond, temp, TempAddr;
+    int offset, temp;
+    cell TempAddr;
 
-    temp = offset = PopDs(&cond);
-    if (cond == STACK_ERR_EMPTY) {
-        CompileMode = FALSE;
+    if (PopControl(CTRL_ORIG, &temp) == FALSE) {
+        return;
+    }
+    if (temp < 0) {                             // IF on a literal, the other arm is the one to drop
+        if (temp != ARM_LIVE) {
+            DropArm(ARM_DEAD(temp));
+        }
+        PushControl(temp == ARM_LIVE ? ARM_DEAD(j_pc) : ARM_LIVE, CTRL_ORIG);
         return;
     }
 
@@ -638,16 +901,11 @@ void Else(void) {
     CompileCode[j_pc] = TempAddr;
     j_pc++;
 
-    PushDs(j_pc, &cond);                 // save  PC for Then
+    PushControl(j_pc, CTRL_ORIG);        // save  PC for Then
 
     j_pc++;
 
-    if (cond == STACK_ERR_FULL) {
-        CompileMode = FALSE;
-        return;
-    }
-
-    offset = j_pc - offset;
+    offset = j_pc - temp;
     CompileCode[temp] = offset;
 }
 
@@ -658,14 +916,8 @@ void Else(void) {
  */
 
 void Begin(void) {
-    int cond;
-    PushDs(j_pc, &cond);
-
-    if (cond == STACK_ERR_FULL) {
-        CompileMode = FALSE;
-        return ;
-    }
-}
+    PushControl(j_pc, CTRL_DEST);
+}
 
 /**
  * \fn     Until(void)
@@ -673,12 +925,10 @@ void Begin(void) {
  */
 
 void Until(void) {
-    int cond, offset, TempAddr;
+    int offset;
+    cell TempAddr;
 
-    offset = PopDs(&cond);
-
-    if (cond == STACK_ERR_EMPTY) {
-        CompileMode = FALSE;
+    if (PopControl(CTRL_DEST, &offset) == FALSE) {
         return ;
     }
 
@@ -693,1028 +943,1207 @@ void Until(void) {
 }
 
 /**
- * \fn     Equal(void)
- * \brief  Implements conditional operator =
+ * \fn     While(void)
+ * \brief  Implements While of Forth language, BEGIN ... flag WHILE ... REPEAT leaves the loop when flag is false
  */
 
-void Equal (void) {
-    int cond, temp1, temp2;
-
-    temp1 = PopDs(&cond);
-    temp2 = PopDs(&cond);
+void While(void) {
+    int dest;
 
-    if (cond == STACK_ERR_EMPTY) {
-        return;
+    if (PopControl(CTRL_DEST, &dest) == FALSE) {
+        return ;
     }
 
-    if (temp1 == temp2) {
-        PushDs(FORTH_TRUE, &cond);              // indicate true
-    } else {
-        PushDs(FORTH_FALSE, &cond);              // indicate false
-    }
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_0BRANCH];
+    PushControl(j_pc, CTRL_ORIG);               // patched by REPEAT
+    CompileCode[j_pc++] = 0;
+    PushControl(dest, CTRL_DEST);               // BEGIN stays on top for REPEAT
 }
 
-
 /**
- * \fn     GT(void)
- * \brief  Implements comparision operator >
+ * \fn     Again(void)
+ * \brief  Implements Again of Forth language, branches back to BEGIN for ever
  */
 
-void GT (void) {
-    int cond, temp1, temp2;
-
-    temp1 = PopDs(&cond);
-    temp2 = PopDs(&cond);
+void Again(void) {
+    int offset;
 
-    if (cond == STACK_ERR_EMPTY) {
-        return;
+    if (PopControl(CTRL_DEST, &offset) == FALSE) {
+        return ;
     }
 
-    if (temp2 > temp1) {
-        PushDs(FORTH_TRUE, &cond);              // indicate true
-    } else {
-        PushDs(FORTH_FALSE, &cond);              // indicate false
-    }
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_BRANCH];
+    CompileCode[j_pc] = offset - j_pc;          // negative offset
+    j_pc++;
 }
 
 /**
- * \fn     LT(void)
- * \brief  Implements comparision operator <
+ * \fn     Repeat(void)
+ * \brief  Implements Repeat of Forth language, branches back to BEGIN and resolves the WHILE before it
  */
 
-void LT (void) {
-    int cond, temp1, temp2;
-
-    temp1 = PopDs(&cond);
-    temp2 = PopDs(&cond);
-
-    if (cond == STACK_ERR_EMPTY) {
+void Repeat(void) {
+    Again();
+    if (CompileFailed == TRUE) {
         return;
     }
-
-    if (temp2 < temp1) {
-        PushDs(FORTH_TRUE, &cond);              // indicate true
-    } else {
-        PushDs(FORTH_FALSE, &cond);              // indicate false
-    }
+    Then();                                     // the WHILE, or an IF on a literal in its place
 }
 
 /**
- * \fn     LTE(void)
- * \brief  Implements conditional operator <=
+ * \fn     Recurse(void)
+ * \brief  Compiles a call to the word being defined, which Find() does not see until its definition is over
  */
 
-void LTE (void) {
-    int cond, temp1, temp2;
-
-    temp1 = PopDs(&cond);
-    temp2 = PopDs(&cond);
-
-    if (cond == STACK_ERR_EMPTY) {
+void Recurse(void) {
+    if (PendingEntry() == NULL) {               // a line at the prompt, there is no word to call
+        CompileFail();
         return;
     }
-
-    if (temp2 <= temp1) {
-        PushDs(FORTH_TRUE, &cond);              // indicate true
-    } else {
-        PushDs(FORTH_FALSE, &cond);              // indicate false
-    }
+    CompileCode[j_pc++] = (cell)PendingEntry();
 }
 
-
-
 /**
- * \fn     GTE(void)
- * \brief  Implements conditional operator >=
+ *  Counted loops. DO compiles (DO) and remembers where the body starts, LOOP and +LOOP compile the branch back to
+ *  it. The exits of the loop, the offsets of ?DO and of every LEAVE, are chained through their offset cells
+ *  starting at \a LeaveChain and patched by LOOP once it knows where the loop ends. DO saves the chain of the
+ *  loop around it on the control stack below the start of its body, like the other control words do.
  */
 
-
-void GTE (void) {
-    int cond, temp1, temp2;
-
-    temp1 = PopDs(&cond);
-    temp2 = PopDs(&cond);
-
-    if (cond == STACK_ERR_EMPTY) {
-        return;
-    }
-
-    if (temp2 >= temp1) {
-        PushDs(FORTH_TRUE, &cond);              // indicate true
-    } else {
-        PushDs(FORTH_FALSE, &cond);              // indicate false
-    }
-}
-
-
+static int LeaveChain;                  /**< Last exit of the innermost loop being compiled to be patched, 0 if none */
+static int LoopDepth;                   /**< Loops open in the word being compiled */
 
 /**
- *  \fn     StopCompile(void)
- *  \brief  Exits from compile mode, sets \a CompileMode flag to FALSE
+ *  CASE ... ENDCASE. Every clause is compiled the usual way, value OVER = 0BRANCH DROP ... BRANCH, and noted in
+ *  \a Clauses. When ENDCASE finds that every OF of the CASE compares against a literal and the literals are
+ *  dense, it replaces the comparisons by a (CASE) jump table indexed by the selector, see LowerCase(). The bodies
+ *  keep their DROP of the selector, the table only picks the one to run, so a CASE costs the same whichever of
+ *  its clauses is taken. \a CaseStart and \a CaseBase of the CASE around it are saved on the control stack.
  */
 
-void StopCompile(void) {
-    CompileMode = FALSE;
-
-}
-
-
+static struct {
+    int head;                           /**< First cell of the LIT before OF, -1 if the value is not a literal */
+    int body;                           /**< The DROP after 0BRANCH, where the clause runs from */
+    int end;                            /**< Just past the BRANCH of ENDOF, 0 while the clause is open */
+    int moved;                          /**< Where the body ends up in the jump table version */
+    cell value;                         /**< The literal */
+} Clauses[CASE_CLAUSES];
 
+static int ClauseTop;                   /**< Clauses noted */
+static int CaseBase;                    /**< First clause of the innermost CASE */
+static int CaseStart;                   /**< Cell the innermost CASE starts at */
+static int CaseDepth;                   /**< CASEs open in the word being compiled */
 
 /**
- *  \fn      DotStr(void)
- *  \brief   Compiles a string in a word.
- *  \note    This function is strictly tied to 32-bit architecture and also Unicode characters cannot be used with this function
+ *  \fn      StartLoop(int prim)
+ *  \brief   Compiles (DO) or (?DO) and saves what LOOP needs
  */
 
-extern char CmdBuff[];
-extern int CmdPos;
-void DotStr(void) {
-    int TempAddr;
-    int i=0;
-
-
-    Find("STR", &TempAddr);        // get the word which actually prints out the string
-
-    CompileCode[j_pc] = TempAddr;
-    j_pc++;
-
-    CmdPos++;                     // skip the blank
+static void StartLoop(int prim) {
+    int cond;
 
-    while (CmdBuff[CmdPos] != '\"') {
-        //CompileCode[j_pc] = CmdBuff[CmdPos];
-        CompileCode[j_pc] = 0;
-        for (i=0; i<ARCHITECTURE; i++) {
-            if (CmdBuff[CmdPos] == '\"' || CmdBuff[CmdPos] == 0x0d) {
-                break;
-            }
-            CompileCode[j_pc] |= CmdBuff[CmdPos] << (i*ARCHITECTURE*2);   // shift and pack the data
-            CmdPos++;
-        }
-        j_pc++;
+    CompileCode[j_pc++] = (cell)PrimNode[prim];
+    PushDs(LeaveChain, &cond);
+    LeaveChain = 0;
+    if (prim == PRIM_QDO) {
+        CompileCode[j_pc] = 0;          // skips to the end of the loop, patched by LOOP
+        LeaveChain = j_pc++;
     }
-
-    CmdPos++;                      // skip "
-
-    if (i>0) {
-        while (i != 0) {
-            CompileCode[j_pc] |= 0 << (i*ARCHITECTURE);        // fill remaining fields
-            i--;
-        }
-    } else {
-        CompileCode[j_pc] = 0;         // indicate end of string
+    PushControl(j_pc, CTRL_DO);
+    if (CompileFailed == TRUE) {
+        return;
     }
-    j_pc++;
+    LoopDepth++;
 }
 
-
 /**
- *  \fn      DispStr(void)
- *  \brief   Displays the string
- *  \note    This function is strictly tied to 32-bit architecture and also Unicode characters cannot be used with this function
+ *  \fn      EndLoop(int prim)
+ *  \brief   Compiles (LOOP) or (+LOOP) back to the start of the body and patches the exits of the loop
  */
 
-bool lcd_st_txt = false;          /**< This flag will be set by the word that targets the static text, somewhere down this file */
-int lcd_st_id;                    /**< The word resposnisble for setting text of a string should load approporiate id to this variable */
-bool lcd_bmp = false;            /**< Similar to \a lcd_st_txt but works on bmp control */
-int lcd_bmp_id;                  /**< Same as \a lcd_st_id but works on bit map */
-
-void DispStr(void) {
-
-    char temp;
-    char buff[MAX_TXT], temp_buff[2];
-    int tempi, cond, Addr, packed, i=0;
-    NodePtr CodePtr;
-
-    Addr = PopRs(&cond);         // get the address
-    tempi = PopRs(&cond);
+static void EndLoop(int prim) {
+    int cond, start, at, next;
 
+    if (LoopDepth == 0) {
+        printf ("\nLOOP without DO ");
+        CompileFail();
+        return;
+    }
+    if (PopControl(CTRL_DO, &start) == FALSE) {
+        return;
+    }
 
-    buff[0] = '\0';            // this array will hold the unpacked string
-    temp = 5;                 // to start with
-    while (temp != 0) {
-        CodePtr = (NodePtr)Addr;
-        packed = CodePtr->code[tempi];  // read the number
+    CompileCode[j_pc++] = (cell)PrimNode[prim];
+    CompileCode[j_pc] = start - j_pc;           // negative offset
+    j_pc++;
 
-        for (i=0; i<ARCHITECTURE; i++) {
-            temp = (char)(packed & 0xFF);
-            if (temp == 0) break;
-            sprintf (temp_buff, "%c", temp);
-            strcat(buff, temp_buff);
-            packed = packed >> ARCHITECTURE*2;
-        }
-        tempi++;
+    for (at=LeaveChain; at!=0; at=next) {
+        next = CompileCode[at];
+        CompileCode[at] = j_pc - at;
     }
+    LeaveChain = PopDs(&cond);
+    LoopDepth--;
+}
 
-    if ( i > 0) tempi++;
+/**
+ *  \fn      DropArm(int at)
+ *  \brief   Drops the code compiled from \a at on, the arm of an IF which never runs
+ *
+ *           Whatever the arm opened it has closed again, only the LEAVEs in it of a loop around the IF are still
+ *           chained from \a LeaveChain and are unlinked.
+ */
 
-    if (lcd_st_txt == true) {
-        if (lcd_st_id != -1) { // no error
-            SetStText(lcd_st_id, buff);
-        }
-        lcd_st_txt = false;
-    } else if (lcd_bmp == true) {
-        if (lcd_bmp_id != -1 ) {
-            UpdateBMP(lcd_bmp_id, buff);
-        }
-        lcd_bmp = false;   // ready the flag for next run
+static void DropArm(int at) {
+#if FORTH_FOLD_DEBUG
+    printf ("\nDropped %d cells ", j_pc - at);
+#endif
+    while (LeaveChain >= at && LeaveChain != 0) {
+        LeaveChain = CompileCode[LeaveChain];
     }
+    j_pc = at;
+}
 
-    else {
-        // go to stdout
-        printf ("%s", buff);
-    }
+/**
+ *  \fn      StartDefinition(void)
+ *  \brief   Forgets the loops and CASEs of a definition which was abandoned half way, called by :
+ */
 
-    PushRs(tempi, &cond);   // store back the address so that interpreter can continue what it was doing
-    PushRs(Addr, &cond);      // after skipping the offset number
+void StartDefinition(void) {
+    LeaveChain = 0;
+    LoopDepth = 0;
+    ClauseTop = CaseBase = CaseStart = CaseDepth = 0;
 }
 
-
 /**
- *   \fn       SkipComment1(void)
- *   \brief    Skips line comments that start with    \
+ *  \fn      Do(void)
+ *  \brief   Starts a counted loop ( limit start -- ), the body runs for start, start+1 .. limit-1
  */
 
-void SkipComment1(void) {
-    RESET_CMDPOS;             // skip every thing there is in input buffer
-    CmdBuff[0] = '\0';        // empty the string buffer
+void Do(void) {
+    StartLoop(PRIM_DO);
 }
 
-
 /**
- *  \fn      SkipComment2(void)
- *  \brief   This skips inline/parantesized comment starting with ( and ending with )
+ *  \fn      QueryDo(void)
+ *  \brief   As DO, but does not run the body at all if limit and start are equal
  */
 
-void SkipComment2(void) {
-    while (CmdBuff[CmdPos] != '\0') {
-        if (CmdBuff[CmdPos] == ')') {
-            break;
-        }
-        CmdPos++;
-    }
-    CmdPos++;
+void QueryDo(void) {
+    StartLoop(PRIM_QDO);
 }
 
-
 /**
- *    \fn       Not(void)
- *    \brief    Inverts the truth value of Top of stack
- *
+ *  \fn      Loop(void)
+ *  \brief   Ends a counted loop, adds one to the index
  */
 
-void Not(void) {
-    int cond;
-
-    PopDs(&cond)?PushDs(FORTH_FALSE, &cond):PushDs(FORTH_TRUE, &cond);
+void Loop(void) {
+    EndLoop(PRIM_LOOP);
 }
 
 /**
- *   \fn       And(void)
- *   \brief    performs logical 'and' on TOS and NOS. Leaves the result on TOS
- *
-*/
+ *  \fn      PlusLoop(void)
+ *  \brief   Ends a counted loop, adds n to the index ( n -- ) and stops when it crosses the limit
+ */
 
-void And(void) {
-    int temp1, temp2, cond;
+void PlusLoop(void) {
+    EndLoop(PRIM_PLOOP);
+}
 
-    temp1 = PopDs(&cond);
-    temp2 = PopDs(&cond);
+/**
+ *  \fn      CompileIndex(int prim, int loops)
+ *  \brief   Compiles (I) or (J), which read the parameters of one of the \a loops innermost loops
+ */
 
-    if (cond == STACK_ERR_EMPTY) {
+static void CompileIndex(int prim, int loops) {
+    if (LoopDepth < loops) {
+        printf ("\n%s outside %s ", prim == PRIM_I ? "I" : "J", loops == 1 ? "a loop" : "two loops");
+        CompileFail();
         return;
     }
+    CompileCode[j_pc++] = (cell)PrimNode[prim];
+}
 
-    temp1 = temp1 & temp2;
+/**
+ *  \fn      CompileI(void)
+ *  \brief   Compiles I, the index of the innermost loop ( -- n )
+ */
 
-    PushDs(temp1, &cond);
+void CompileI(void) {
+    CompileIndex(PRIM_I, 1);
 }
 
-
 /**
- *   \fn       Or(void)
- *   \brief    performs logical 'or' on TOS and NOS. Leaves the result on TOS
- *
+ *  \fn      CompileJ(void)
+ *  \brief   Compiles J, the index of the loop around the innermost one ( -- n )
  */
 
-void Or(void) {
-    int temp1, temp2, cond;
+void CompileJ(void) {
+    CompileIndex(PRIM_J, 2);
+}
 
-    temp1 = PopDs(&cond);
-    temp2 = PopDs(&cond);
+/**
+ *  \fn      Leave(void)
+ *  \brief   Leaves the innermost loop straight away, compiles (UNLOOP) and a branch to its end
+ */
 
-    if (cond == STACK_ERR_EMPTY) {
+void Leave(void) {
+    if (LoopDepth == 0) {
+        printf ("\nLEAVE outside a loop ");
+        CompileFail();
         return;
     }
-
-    temp1 = temp1 | temp2;
-
-    PushDs(temp1, &cond);
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_UNLOOP];
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_BRANCH];
+    CompileCode[j_pc] = LeaveChain;             // patched by LOOP
+    LeaveChain = j_pc++;
 }
 
 /**
- *   \fn       Xor(void)
- *   \brief    performs logical 'Xor' on TOS and NOS. Leaves the result on TOS
- *
+ *  \fn      Unloop(void)
+ *  \brief   Compiles (UNLOOP), which drops the parameters of the innermost loop before leaving the word
  */
 
-void Xor(void) {
-    int temp1, temp2, cond;
-
-    temp1 = PopDs(&cond);
-    temp2 = PopDs(&cond);
-
-    if (cond == STACK_ERR_EMPTY) {
+void Unloop(void) {
+    if (LoopDepth == 0) {
+        printf ("\nUNLOOP outside a loop ");
+        CompileFail();
         return;
     }
-
-    temp1 = temp1 ^ temp2;
-
-    PushDs(temp1, &cond);
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_UNLOOP];
 }
 
 /**
- *    \fn      BitSet(void)
- *    \brief   Tests if a particular bit of next on sack is set. TOS should have bit position to be tested.
- *             Leaves TOS with the TRUE value if bit was set or else leaves FALSE value.
+ *  Run time of the counted loops. The inner interpreter executes them itself, these are only used when it is
+ *  built without \a FORTH_PRIM_DISPATCH.
  */
 
-void BitSet(void) {
-    int temp1, temp2, cond;
-
-    temp1 = PopDs(&cond);
-    temp2 = PopDs(&cond);
+void DoParams(void) {
+    cell limit, start;
+    int cond;
 
+    start = PopDs(&cond);
+    limit = PopDs(&cond);
     if (cond == STACK_ERR_EMPTY) {
         return;
     }
-
-    (1 << temp1) & temp2 ? PushDs(FORTH_TRUE, &cond):PushDs(FORTH_FALSE, &cond);
-
+    PushRs(limit, &cond);
+    PushRs(start, &cond);
 }
 
+void QueryDoParams(void) {
+    if (DatStackTop >= 2 && DatStack[DatStackTop-1] == DatStack[DatStackTop-2]) {
+        DatStackTop -= 2;
+        IP += CODE_OFFSET(IP);
+    } else {
+        IP++;
+        DoParams();
+    }
+}
 
-/**
- *    \fn      BitClear(void)
- *    \brief   Tests if a particular bit of next on sack is reset. TOS should have bit position to be tested.
- *             Leaves TOS with the TRUE value if bit was reset or else leaves FALSE value.
- */
-
-void BitClear(void) {
-    int temp1, temp2, cond;
+void LoopBranch(void) {
+    if (++RetStack[RetStackTop-1] != RetStack[RetStackTop-2]) {
+        IP += CODE_OFFSET(IP);
+    } else {
+        RetStackTop -= 2;
+        IP++;
+    }
+}
 
-    temp1 = PopDs(&cond);
-    temp2 = PopDs(&cond);
+void PlusLoopBranch(void) {
+    ucell before, after;
+    cell step;
+    int cond;
 
+    step = PopDs(&cond);
     if (cond == STACK_ERR_EMPTY) {
-        return;
+        step = 1;
+    }
+    before = (ucell)RetStack[RetStackTop-1] - (ucell)RetStack[RetStackTop-2];
+    after = before + (ucell)step;
+    RetStack[RetStackTop-1] += step;
+    if ((cell)(before ^ after) >= 0) {
+        IP += CODE_OFFSET(IP);
+    } else {
+        RetStackTop -= 2;
+        IP++;
     }
+}
 
-    (~(1 << temp1)) & temp2 ? PushDs(FORTH_TRUE, &cond):PushDs(FORTH_FALSE, &cond);
+void LoopIndex(void) {
+    int cond;
 
+    PushDs(RetStackTop >= 1 ? RetStack[RetStackTop-1] : 0, &cond);
 }
 
-/**
-* This function emits a new line
-*/
-void Cr(void) {
-    printf ("\n");
-}
+void OuterIndex(void) {
+    int cond;
 
+    PushDs(RetStackTop >= 3 ? RetStack[RetStackTop-3] : 0, &cond);
+}
 
-// ------------------------------------------------------------------------
+void UnloopParams(void) {
+    if (RetStackTop >= 2) {
+        RetStackTop -= 2;
+    }
+}
 
 /**
- *  \fn     DelayInSec(void)
- *  \brief  Delays execution in seconds, obtained from data stack
+ *  \fn      MovedTo(int at)
+ *  \brief   Where a cell of a body or of the default of the innermost CASE ends up in LowerCase()
  */
 
-void DelayInSec(void) {
-    int temp, cond;
-
-    temp = PopDs(&cond);
+static int MovedTo(int at) {
+    int i;
 
-    if (cond == STACK_ERR_EMPTY) {
-        return;
+    for (i=ClauseTop-1; i>CaseBase && at<Clauses[i].body; i--) {
     }
+    return Clauses[i].moved + at - Clauses[i].body;        // the default follows the last body
+}
 
-    wait(temp);
+/**
+ *  \fn      LowerCase(void)
+ *  \brief   Compiles the innermost CASE to a jump table if it is worth it, called by ENDCASE
+ *
+ *           The table goes where the first clause started and the bodies follow it in order, the heads are
+ *           dropped:
+ *
+ *           (CASE) min span offset(min) .. offset(min+span-1) offset(default)  body ... body  default DROP
+ *
+ *           A value without an OF and one outside of the table take the default. The new code is put together
+ *           past the end of the word and copied back, it is never longer than the old one. LEAVEs in the bodies
+ *           are chained through cells which move, \a LeaveChain is fixed up for them.
+ */
+
+static void LowerCase(void) {
+    cell lo, hi;
+    cell *table;
+    int i, n, t, span, at, next;
+
+    n = ClauseTop - CaseBase;
+    if (n < CASE_TABLE_MIN) {
+        return;
+    }
+    lo = hi = Clauses[CaseBase].value;
+    for (i=CaseBase; i<ClauseTop; i++) {
+        if (Clauses[i].head < 0) {
+            return;
+        }
+        if (Clauses[i].value < lo) {
+            lo = Clauses[i].value;
+        }
+        if (Clauses[i].value > hi) {
+            hi = Clauses[i].value;
+        }
+    }
+    if ((ucell)hi - (ucell)lo >= (ucell)(CASE_TABLE_FILL * n)) {
+        return;                                             // too sparse
+    }
+    span = (int)(hi - lo) + 1;
+
+    if (DicRoom() < (int)sizeof(struct Node) + (2*j_pc - CaseStart) * (int)sizeof(cell)) {
+        return;
+    }
+
+    table = &CompileCode[j_pc];                             // scratch, past the end of the word
+    table[0] = (cell)PrimNode[PRIM_CASE];
+    table[1] = lo;
+    table[2] = span;
+    for (i=0; i<=span; i++) {
+        table[3+i] = 0;
+    }
+    t = 4 + span;
+    for (i=CaseBase; i<ClauseTop; i++) {
+        at = 3 + (int)(Clauses[i].value - lo);
+        if (table[at] == 0) {                               // the first OF of a value wins
+            table[at] = t - at;
+        }
+        Clauses[i].moved = CaseStart + t;
+        n = Clauses[i].end - Clauses[i].body;
+        memcpy(&table[t], &CompileCode[Clauses[i].body], n * sizeof(cell));
+        t += n;
+    }
+    at = Clauses[ClauseTop-1].end;                          // default and DROP
+    memcpy(&table[t], &CompileCode[at], (j_pc - at) * sizeof(cell));
+    for (i=0; i<=span; i++) {
+        if (table[3+i] == 0) {
+            table[3+i] = t - (3+i);
+        }
+    }
+    t += j_pc - at;
+    for (i=CaseBase; i<ClauseTop; i++) {                    // ENDOF branches to the new end
+        at = MovedTo(Clauses[i].end) - CaseStart - 1;
+        table[at] = t - at;
+    }
+
+    for (at=LeaveChain; at>CaseStart; at=next) {
+        next = (int)table[MovedTo(at) - CaseStart];
+        if (next > CaseStart) {
+            table[MovedTo(at) - CaseStart] = MovedTo(next);
+        }
+    }
+    if (LeaveChain > CaseStart) {
+        LeaveChain = MovedTo(LeaveChain);
+    }
 
+    memmove(&CompileCode[CaseStart], table, t * sizeof(cell));
+    j_pc = CaseStart + t;
 }
 
 /**
-*   This function causes the execution to come out of the main loop
-*/
+ *  \fn      Case(void)
+ *  \brief   Starts a CASE ( x -- x ), the clauses after it test x
+ */
 
-bool exit_ml = false;
+void Case(void) {
+    int cond;
 
-void ExitMainLoop(void) {
-    exit_ml = true;
+    PushDs(CaseBase, &cond);
+    PushControl(CaseStart, CTRL_CASE);
+    if (CompileFailed == TRUE) {
+        return;
+    }
+    CaseStart = j_pc;
+    CaseBase = ClauseTop;
+    CaseDepth++;
 }
 
 /**
- *  \fn         MainLoop(void)
- *  \brief      Word call back
-*/
+ *  \fn      Of(void)
+ *  \brief   Starts a clause ( x v -- x | ), runs it with x dropped when x equals v, else skips to the next one
+ */
 
-void MainLoop(void) {
-    int ret, id;
-    int cmd_pos_temp;
-    char cmd_buff_temp[50];
-    char cb_wrd[MAX_WRD_SIZE];
+void Of(void) {
+    int at;
 
-    strcpy(cmd_buff_temp, CmdBuff);  // save the context
-    cmd_pos_temp = CmdPos;
+    if (CaseDepth == 0 || Innermost(CTRL_CASE) == FALSE) {
+        printf ("\nOF outside a CASE ");
+        CompileFail();
+        return;
+    }
+    if (ClauseTop == CASE_CLAUSES || (ClauseTop > CaseBase && Clauses[ClauseTop-1].end == 0)) {
+        printf ("\nToo many OFs or OF without ENDOF ");
+        CompileFail();
+        return;
+    }
 
-    while (1) {
+    at = (ClauseTop > CaseBase) ? Clauses[ClauseTop-1].end : CaseStart;
+    Clauses[ClauseTop].head = -1;
+    if (j_pc == at+2 && CompileCode[at] == (cell)PrimNode[PRIM_LIT]) {
+        Clauses[ClauseTop].head = at;
+        Clauses[ClauseTop].value = CompileCode[at+1];
+    }
 
-        ret = NO_EVENT;
-        while (ret != EVENT) {
-            // wait for an event
-            ret = Dispatcher(cb_wrd, &id);
-        }
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_OVER];
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_EQ];
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_0BRANCH];
+    CompileCode[j_pc++] = 0;                                // patched by ENDOF
+    Clauses[ClauseTop].body = j_pc;
+    Clauses[ClauseTop].end = 0;
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_DROP];
+    ClauseTop++;
+}
 
-        strcpy(CmdBuff, cb_wrd);         // load with the new context
-        CmdPos = 0;
+/**
+ *  \fn      EndOf(void)
+ *  \brief   Ends a clause, branches to the end of the CASE
+ */
 
-        ret = Interpret();
+void EndOf(void) {
+    int at;
 
-        if (exit_ml == true) {
-            exit_ml = false;            // ready the flag for next round
-            break;
-        }
+    if (CaseDepth == 0 || ClauseTop == CaseBase || Clauses[ClauseTop-1].end != 0 || Innermost(CTRL_CASE) == FALSE) {
+        printf ("\nENDOF without OF ");
+        CompileFail();
+        return;
     }
 
-    CmdPos = cmd_pos_temp;
-    strcpy(CmdBuff, cmd_buff_temp);
-
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_BRANCH];
+    CompileCode[j_pc++] = 0;                                // patched by ENDCASE
+    Clauses[ClauseTop-1].end = j_pc;
+    at = Clauses[ClauseTop-1].body - 1;
+    CompileCode[at] = j_pc - at;                            // x differs, on to the next clause
 }
 
-
 /**
- * Executes the ticker word
+ *  \fn      EndCase(void)
+ *  \brief   Ends a CASE, drops x if no clause took it
  */
 
-char ticker_cb[20];            /*< Ticker callback word name */
-Ticker tickWord;               /*< Ticker */
-
-void CallBackTick(void) {
-    int cmd_pos_temp;
-    int res;
-    char cmd_buff_temp[50];
+void EndCase(void) {
+    int i, at, cond, start;
 
-    strcpy(cmd_buff_temp, CmdBuff);  // save the context
-    cmd_pos_temp = CmdPos;
-    CmdPos = 0;
-    strcpy(CmdBuff, ticker_cb);
-
-    res = Interpret();               // execute the word
+    if (CaseDepth == 0 || (ClauseTop > CaseBase && Clauses[ClauseTop-1].end == 0)) {
+        printf ("\nENDCASE without CASE or OF without ENDOF ");
+        CompileFail();
+        return;
+    }
+    if (PopControl(CTRL_CASE, &start) == FALSE) {       // start of the CASE around this one
+        return;
+    }
 
-    if (res == COMPILE_ERROR || res == STOP_FORTH_INTERPRET) {
-        // error while executing the word. No word defined ?
-        tickWord.detach();
+    CompileCode[j_pc++] = (cell)PrimNode[PRIM_DROP];
+    for (i=CaseBase; i<ClauseTop; i++) {
+        at = Clauses[i].end - 1;
+        CompileCode[at] = j_pc - at;
     }
-    CmdPos = cmd_pos_temp;
-    strcpy(CmdBuff, cmd_buff_temp);
+    LowerCase();
 
+    ClauseTop = CaseBase;
+    CaseBase = PopDs(&cond);
+    CaseStart = start;
+    CaseDepth--;
 }
 
 /**
- * Adds a ticker word
+ *  \fn      CaseBranch(void)
+ *  \brief   Run time of the jump table, the inner interpreter executes it itself unless built without
+ *           \a FORTH_PRIM_DISPATCH
  */
 
-void AddTicker(void) {
-    int del, cond;
-    Word(ticker_cb);
+void CaseBranch(void) {
+    cell temp;
 
-    if (ticker_cb[0] == '\0') {
-        printf ("\nPlease specify a callback word for the ticker ");
+    if (DatStackTop < 1) {
         return;
     }
-    ToUp(ticker_cb);
-
-    del = PopDs(&cond);
-    if (cond == STACK_ERR_EMPTY) {
-        printf ("\nThis word requires delay in seconds to be pushed onto stack ");
-        return;
+    temp = DatStack[DatStackTop-1] - CODE_CELL(IP);
+    IP += CELL_UNITS;
+    if ((ucell)temp >= (ucell)*IP) {
+        temp = *IP;
     }
+    IP += 1 + temp;
+    IP += CODE_OFFSET(IP);
+}
 
-    // else
-    tickWord.attach(&CallBackTick, del);       // no real delays
+/**
+ *  \fn      TailCall(void)
+ *  \brief   Run time of (TAIL), carries on in the word called without a return frame, the inner interpreter
+ *           executes it itself unless built without \a FORTH_PRIM_DISPATCH
+ */
 
+void TailCall(void) {
+    IP = (code_unit*)CODE_XT(IP)->code;
 }
 
 /**
- * Creates a button with given parameters.
- * On stack, the parameter list is x, y id crt_btn "button_name" "button_lbl" call_back_wrd
+ * \fn     Equal(void)
+ * \brief  Implements conditional operator =
  */
 
-extern int skip_flag;
-void CreateBtn(void) {
-    int cond = STACK_ERR_FULL;
-    int id, x, y;
-    char btn_name[GEN_SIZE], btn_lbl[GEN_SIZE], cb_wrd[MAX_WRD_SIZE];
+void Equal (void) {
+    int cond;
+    cell temp1, temp2;
 
-    id = PopDs(&cond);
-    y = PopDs(&cond);
-    x = PopDs(&cond);
+    temp1 = PopDs(&cond);
+    temp2 = PopDs(&cond);
 
     if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
-    }
-    // get button_name and button_label
-    skip_flag = 1;
-    Word(btn_name);
-    skip_flag = 0;
-    if (btn_name[0] == '\0') {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
-    }
-    skip_flag = 1;
-    Word(btn_lbl) ;
-    skip_flag = 0;
-    if (btn_lbl[0] == '\0') {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
-    }
-
-    Word(cb_wrd) ;
-    if (btn_lbl[0] == '\0') {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
+        return;
     }
 
-    ReplaceQuotes(btn_lbl);
-    ReplaceQuotes(btn_name);
-    ToUp(cb_wrd);
-    cond = AddButton(id, btn_lbl, btn_name, cb_wrd, x, y);
-    if (cond == ERR_ERROR) {
-        printf (ERR_TABLE[COULD_NOT_ADD_GUI]);
-        ErrorCond(FORTH_FALSE);
+    if (temp1 == temp2) {
+        PushDs(FORTH_TRUE, &cond);              // indicate true
+    } else {
+        PushDs(FORTH_FALSE, &cond);              // indicate false
     }
-    ErrorCond(FORTH_TRUE);
 }
 
+
 /**
- * Lays out all the GUI elements
+ * \fn     GT(void)
+ * \brief  Implements comparision operator >
  */
 
-void ShowWidgets(void) {
-    DrawControls();
+void GT (void) {
+    int cond;
+    cell temp1, temp2;
+
+    temp1 = PopDs(&cond);
+    temp2 = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
+
+    if (temp2 > temp1) {
+        PushDs(FORTH_TRUE, &cond);              // indicate true
+    } else {
+        PushDs(FORTH_FALSE, &cond);              // indicate false
+    }
 }
 
 /**
-*  This word adds a progress bar to the widget list
-*/
+ * \fn     LT(void)
+ * \brief  Implements comparision operator <
+ */
 
-void CreatePBar(void) {
-    int id, cond, x, y;
-    char p_name[GEN_SIZE];
-    cond = STACK_ERR_FULL;
+void LT (void) {
+    int cond;
+    cell temp1, temp2;
 
-    id = PopDs(&cond);
-    y = PopDs(&cond);
-    x = PopDs(&cond);
+    temp1 = PopDs(&cond);
+    temp2 = PopDs(&cond);
 
     if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
-    }
-    // get button_name and button_label
-    skip_flag = 1;
-    Word(p_name);
-    skip_flag = 0;
-    if (p_name[0] == '\0') {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
+        return;
     }
 
-    ReplaceQuotes(p_name);
-    cond = AddPBar(id, p_name, x, y);
-    if (cond == ERR_ERROR) {
-        printf (ERR_TABLE[COULD_NOT_ADD_GUI]);
-        ErrorCond(FORTH_FALSE);
+    if (temp2 < temp1) {
+        PushDs(FORTH_TRUE, &cond);              // indicate true
+    } else {
+        PushDs(FORTH_FALSE, &cond);              // indicate false
     }
-    ErrorCond(FORTH_TRUE);
 }
 
 /**
-*  This function sets volume for a progress bar
-*/
+ * \fn     LTE(void)
+ * \brief  Implements conditional operator <=
+ */
 
-void SetPBar(void) {
-    int id, cond, vol;
-    cond = STACK_ERR_FULL;
-    id = PopDs(&cond);
-    vol = PopDs(&cond);
+void LTE (void) {
+    int cond;
+    cell temp1, temp2;
 
+    temp1 = PopDs(&cond);
+    temp2 = PopDs(&cond);
 
     if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
+        return;
     }
-    cond = SetPBar(id, vol);
 
-    if (cond == ERR_ERROR) {
-        printf (ERR_TABLE[GUI_NOT_FOUND]);
-        printf ("%d", id);
-        ErrorCond(FORTH_FALSE);
+    if (temp2 <= temp1) {
+        PushDs(FORTH_TRUE, &cond);              // indicate true
+    } else {
+        PushDs(FORTH_FALSE, &cond);              // indicate false
     }
-    ErrorCond(FORTH_TRUE);
 }
 
+
+
 /**
-*  This function creates a static text control
-*  f_Color b_bolor x y id crt_sttxt name text
-*/
+ * \fn     GTE(void)
+ * \brief  Implements conditional operator >=
+ */
 
-extern int *color_table;
 
-void CreateStTxt(void) {
-    int id, cond, x, y, f_clr, b_clr;
-    char txt_name[GEN_SIZE], txt[GEN_SIZE];
-    cond = STACK_ERR_FULL;
+void GTE (void) {
+    int cond;
+    cell temp1, temp2;
 
-    id = PopDs(&cond);
-    y = PopDs(&cond);
-    x = PopDs(&cond);
-    b_clr = PopDs(&cond);
-    f_clr = PopDs(&cond);
+    temp1 = PopDs(&cond);
+    temp2 = PopDs(&cond);
 
     if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
+        return;
     }
 
-    f_clr = ColorVal(f_clr);
-    b_clr = ColorVal(b_clr);
-    // get name and text
-    skip_flag = 1;
-    Word(txt_name);
-    skip_flag = 0;
-    if (txt_name[0] == '\0') {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
-    }
-    skip_flag = 1;
-    Word(txt);
-    skip_flag = 0;
-    if (txt[0] == '\0') {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
+    if (temp2 >= temp1) {
+        PushDs(FORTH_TRUE, &cond);              // indicate true
+    } else {
+        PushDs(FORTH_FALSE, &cond);              // indicate false
     }
+}
 
-    ReplaceQuotes(txt_name);
-    ReplaceQuotes(txt);
-    cond = AddStText(id, txt_name, x, y, txt, f_clr, b_clr);
 
-    if (cond == ERR_ERROR) {
-        printf (ERR_TABLE[COULD_NOT_ADD_GUI]);
-        ErrorCond(FORTH_FALSE);
+
+/**
+ *  \fn     StopCompile(void)
+ *  \brief  Exits from compile mode, sets \a CompileMode flag to FALSE
+ *
+ *          The compiled code is run through the peephole optimiser before the word is entered into the dictionary.
+ */
+
+void StopCompile(void) {
+    if (DatStackTop != 0) {                     // the control stack starts empty, see PushControl()
+        printf ("\nControl structure not closed ");
+        CompileFail();
+        return;
     }
-    ErrorCond(FORTH_TRUE);
+    CompileMode = FALSE;
+    j_pc = FuseCode(CompileCode, j_pc);
 }
 
+
 /**
-* This function sets a text for static text control
-* id set_st_txt ." text "
-*/
+ *  \fn     DotFused(void)
+ *  \brief  Prints how many superinstructions the optimiser made in the last compiled word
+ */
 
-void SetStTxt(void) {
-    int cond;
-    lcd_st_txt = true;
-    lcd_st_id = PopDs(&cond);
+void DotFused(void) {
+    printf ("%d fused in %s ", FuseCount, LATEST->WrdName);
+}
 
-    if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        lcd_st_id = -1;
-        ErrorCond(FORTH_FALSE);
-        return ;
+
+/**
+ *  \fn     MarkInline(int set, int clear)
+ *  \brief  Changes the inline flags of the last word defined, which has to be a user word
+ */
+
+static void MarkInline(int set, int clear) {
+    if (LATEST == NULL || !(LATEST->flag & FORTH_WORD_USER)) {
+        printf ("\nNo word of yours to mark ");
+        return;
     }
+    LATEST->flag = (LATEST->flag & ~clear) | set;
+}
 
+/**
+ *  \fn     Inline(void)
+ *  \brief  Marks the last word defined to be inlined wherever it is compiled, whatever its size
+ */
+
+void Inline(void) {
+    MarkInline(FORTH_WORD_INLINE, FORTH_WORD_NOINLINE);
 }
 
 /**
-*  This function sets fore groud color and back ground color of a static text
-*/
+ *  \fn     NoInline(void)
+ *  \brief  Marks the last word defined to be always called, it then shows up in the profile
+ */
 
-void SetStClr(void) {
-    int id, cond, f_clr, b_clr;
-    cond = STACK_ERR_FULL;
+void NoInline(void) {
+    MarkInline(FORTH_WORD_NOINLINE, FORTH_WORD_INLINE);
+}
 
-    id = PopDs(&cond);
-    b_clr = PopDs(&cond);
-    f_clr = PopDs(&cond);
 
-    if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
-    }
+/**
+ *  Superinstructions made by FuseCode(). The inner interpreter executes them itself, these are only used
+ *  when it is built without \a FORTH_PRIM_DISPATCH.
+ */
 
-    f_clr = ColorVal(f_clr);
-    b_clr = ColorVal(b_clr);
+void LitAdd(void) {
+    Lit();
+    Add();
+}
 
-    id = SetStColor(id, f_clr, b_clr);
+void LitFetch(void) {
+    Lit();
+    Read();
+}
 
-    if (id == ERR_ERROR) {
-        printf (ERR_TABLE[GUI_NOT_FOUND]);
-        printf ("%d", id);
-        ErrorCond(FORTH_FALSE);
-    }
-    ErrorCond(FORTH_TRUE);
+void DupMul(void) {
+    Dup();
+    Mul();
 }
 
+void ZeroEqBranch(void) {
+    int cond;
 
-/**
-* This function writes a digital value to given port pin
-* ( port_val port_position DigitalOut -- )
-*
-* @note  On mbed thereare port form 5 to 30 so valid port_position are from 5 to 30 (inclusive of both)
-*        and for accessing led1-led4, the valid port_positions are 31, 32, 33 and 34
-*/
+    PushDs(0, &cond);
+    Equal();
+    CondBranch();
+}
 
-void SetPort(void) {
-    int cond, port_val, port_index;
-    DigitalOut ports[] = {p9, p9, p9, p9, p9, p10, p11, p12, p13, p14, p15, p16, p17, p18, p19, p20,
-                          p21, p22, p23, p24, p25, p26, p27, p28, p29, LED1, LED1, LED2, LED3, LED4
-                         };
+void TwoDup(void) {
+    Over();
+    Over();
+}
 
-    int max=sizeof(ports)/sizeof(DigitalOut);
 
-    cond = STACK_ERR_FULL;
 
-    port_index = PopDs(&cond);
-    port_val = PopDs(&cond);
 
-    if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        return ;
-    }
+/**
+ *  \fn      DotStr(void)
+ *  \brief   Compiles a string in a word.
+ *  \note    \a ARCHITECTURE characters are packed into a cell, Unicode characters cannot be used with this function
+ */
 
-    port_index = port_index - PORT_OFFSET;       // to index the array elements properly
+extern char* CmdBuff;
+extern int CmdPos;
+void DotStr(void) {
+    cell TempAddr;
+    int i=0;
 
-    if (port_index < 0 || port_index >= max) {
-        printf (ERR_TABLE[INVALID_PORT]);
-        return ;
+
+    Find("STR", &TempAddr);        // get the word which actually prints out the string
+
+    CompileCode[j_pc] = TempAddr;
+    j_pc++;
+
+    CmdPos++;                     // skip the blank
+
+    CompileCode[j_pc] = 0;
+    while (CmdBuff[CmdPos] != '\"' && !IS_EOL(CmdBuff[CmdPos]) && CmdBuff[CmdPos] != 0x0d) {
+        CompileCode[j_pc] |= (cell)(unsigned char)CmdBuff[CmdPos] << (i*8);   // shift and pack the data
+        CmdPos++;
+        i++;
+        if (i == ARCHITECTURE) {
+            j_pc++;               // cell is full, start the next one
+            CompileCode[j_pc] = 0;
+            i = 0;
+        }
     }
-    // set the port values
-    if (port_val == 0) {
-        ports[port_index] = 0;
-    } else {
-        ports[port_index] = 1;
+
+    if (CmdBuff[CmdPos] == '\"') {
+        CmdPos++;                  // skip "
     }
+
+    j_pc++;                        // last cell always has at least one 0 byte to indicate end of string
 }
 
+
 /**
-* This function reads digital logic level at a given port and pushes either 1 or
-* 0 on to stack depending on the logic voltage at that pin
-* ( port_position DigitalIn -- logic_level_at_that_port )
-*
-*/
+ *  \fn      DispStr(void)
+ *  \brief   Displays the string
+ *  \note    \a ARCHITECTURE characters are packed into a cell, two into a unit of token code, Unicode characters
+ *           cannot be used with this function
+ */
 
-void ReadPort(void) {
-    int cond, port_val, port_index;
-    DigitalOut ports[] = {p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15, p16, p17, p18, p19, p20,
-                          p21, p22, p23, p24, p25, p26, p27, p28, p29, p30
-                         };
+void (*StrSink)(char* str);       /**< Set by words such as SET_ST_TXT to send the next string elsewhere than stdout */
 
-    int max=sizeof(ports)/sizeof(DigitalOut);
+void DispStr(void) {
 
-    cond = STACK_ERR_FULL;
+    char temp;
+    char buff[STR_MAX];
+    void (*sink)(char* str);
+    cell packed;
+    int i, len = 0;
+    bool done = FALSE;
 
-    port_index = PopDs(&cond);
+    while (done == FALSE) {
+        packed = *IP;             // read the packed characters
+        IP++;
 
-    if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        return ;
+        for (i=0; i<(int)sizeof(*IP); i++) {
+            temp = (char)(packed & 0xFF);
+            if (temp == 0) {
+                done = TRUE;
+                break;
+            }
+            if (len == STR_MAX-1 && StrSink == NULL) {
+                buff[len] = '\0';  // long strings for stdout go out in pieces
+                printf ("%s", buff);
+                len = 0;
+            }
+            if (len < STR_MAX-1) {
+                buff[len++] = temp;
+            }
+            packed = packed >> 8;
+        }
     }
+    buff[len] = '\0';            // IP now points past the string
 
-    port_index = port_index - PORT_OFFSET;       // to index the array elements properly
-
-    if (port_index < 0 || port_index >= max) {
-        printf (ERR_TABLE[INVALID_PORT]);
-        return ;
+    if (StrSink != NULL) {
+        sink = StrSink;
+        StrSink = NULL;            // ready for next run
+        sink(buff);
+    } else {
+        // go to stdout
+        printf ("%s", buff);
     }
-    port_val = ports[port_index];
-    PushDs(port_val, &cond);
 }
 
-/**
-* Reads analog voltage at a given pin and pushes the value onto stack
-* ( ch_index DigitalIn -- read_value )
-*  channel 0-4 p15-p20
-*/
 
-void AnalogRead(void) {
-    int cond, channel;
-    AnalogIn ain_channels[] = {p15, p16, p17, p18, p19};
+/**
+ *   \fn       SkipComment1(void)
+ *   \brief    Skips line comments that start with    \
+ */
 
-    int max=sizeof(ain_channels)/sizeof(DigitalOut);
+void SkipComment1(void) {
+    SkipLine();               // skip every thing there is in input buffer
+    LineComment = TRUE;       // a long line of a script goes on in the next piece
+}
 
-    cond = STACK_ERR_FULL;
 
-    channel = PopDs(&cond);
+/**
+ *  \fn      SkipComment2(void)
+ *  \brief   This skips inline/parantesized comment starting with ( and ending with )
+ */
 
-    if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        return ;
+void SkipComment2(void) {
+    while (!IS_EOL(CmdBuff[CmdPos])) {
+        if (CmdBuff[CmdPos] == ')') {
+            break;
+        }
+        CmdPos++;
     }
-
-    if (channel < 0 || channel >= max) {
-        printf (ERR_TABLE[INVALID_PORT]);
-        return ;
+    if (CmdBuff[CmdPos] == ')') {
+        CmdPos++;                 // not past the end, a script has its next line there
     }
+}
+
+
+/**
+ *    \fn       Not(void)
+ *    \brief    Inverts the truth value of Top of stack
+ *
+ */
+
+void Not(void) {
+    int cond;
 
-    channel =  ain_channels[channel];
-    PushDs(channel, &cond);
+    PopDs(&cond)?PushDs(FORTH_FALSE, &cond):PushDs(FORTH_TRUE, &cond);
 }
 
 /**
-* Outputs a given analog value at p18 pin
+ *   \fn       And(void)
+ *   \brief    performs logical 'and' on TOS and NOS. Leaves the result on TOS
+ *
 */
 
-void AnalogWrite(void) {
-    int cond, aout_val;
-    AnalogOut aout(p18);
-
-    cond = STACK_ERR_FULL;
+void And(void) {
+    cell temp1, temp2;
+    int cond;
 
-    aout_val = PopDs(&cond);
+    temp1 = PopDs(&cond);
+    temp2 = PopDs(&cond);
 
     if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        return ;
+        return;
     }
 
-    aout = aout_val;
+    temp1 = temp1 & temp2;
+
+    PushDs(temp1, &cond);
 }
 
+
 /**
-* Loads a file from the sd card and executes it
-*/
+ *   \fn       Or(void)
+ *   \brief    performs logical 'or' on TOS and NOS. Leaves the result on TOS
+ *
+ */
 
-void Fload(void) {
-    char file_name[40];
-    int res;
+void Or(void) {
+    cell temp1, temp2;
+    int cond;
 
-    skip_flag = 1;
-    Word(file_name);
-    skip_flag = 0;
-    if (file_name[0] == '\0') {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        return ;
-    }
+    temp1 = PopDs(&cond);
+    temp2 = PopDs(&cond);
 
-    ReplaceQuotes(file_name);
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
 
-    res = ExecFromFile(file_name);
+    temp1 = temp1 | temp2;
 
-    if (res == FILE_NOT_FOUND) {
-        printf (ERR_TABLE[COULD_NOT_FIND_FILE]);
-        printf ("%s", file_name);
-    }
+    PushDs(temp1, &cond);
 }
 
 /**
-* Creates a bit map control.
-* ( x y id crt_bmp "name" "file_name" )
-*/
-
-void AddBmp(void) {
-    int id, cond, x, y;
-    char bmp_name[GEN_SIZE], file_loc[GEN_SIZE];
-    cond = STACK_ERR_FULL;
+ *   \fn       Xor(void)
+ *   \brief    performs logical 'Xor' on TOS and NOS. Leaves the result on TOS
+ *
+ */
 
-    id = PopDs(&cond);
-    y = PopDs(&cond);
-    x = PopDs(&cond);
+void Xor(void) {
+    cell temp1, temp2;
+    int cond;
 
+    temp1 = PopDs(&cond);
+    temp2 = PopDs(&cond);
 
     if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
+        return;
     }
 
-    // get name and text
-    skip_flag = 1;
-    Word(bmp_name);
-    skip_flag = 0;
-    if (bmp_name[0] == '\0') {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
-    }
-    skip_flag = 1;
-    Word(file_loc);
-    skip_flag = 0;
-    if (file_loc[0] == '\0') {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        ErrorCond(FORTH_FALSE);
-        return ;
-    }
+    temp1 = temp1 ^ temp2;
 
-    ReplaceQuotes(bmp_name);
-    ReplaceQuotes(file_loc);
-    if (AddBMP(id, bmp_name, x, y, file_loc) == ERR_ERROR) {
-        printf ("\nError Adding BMP control ");
-        ErrorCond(FORTH_FALSE);
+    PushDs(temp1, &cond);
+}
+
+/**
+ *    \fn      BitSet(void)
+ *    \brief   Tests if a particular bit of next on sack is set. TOS should have bit position to be tested.
+ *             Leaves TOS with the TRUE value if bit was set or else leaves FALSE value.
+ */
+
+void BitSet(void) {
+    cell temp1, temp2;
+    int cond;
+
+    temp1 = PopDs(&cond);
+    temp2 = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
         return;
     }
-    ErrorCond(FORTH_TRUE);
+
+    ((cell)1 << temp1) & temp2 ? PushDs(FORTH_TRUE, &cond):PushDs(FORTH_FALSE, &cond);
 
 }
 
+
 /**
-* Given an id, this function chages the source fr bit map data and
-* redraws it. This function actually sets the flags for STR word.
-*/
+ *    \fn      BitClear(void)
+ *    \brief   Tests if a particular bit of next on sack is reset. TOS should have bit position to be tested.
+ *             Leaves TOS with the TRUE value if bit was reset or else leaves FALSE value.
+ */
+
+void BitClear(void) {
+    cell temp1, temp2;
+    int cond;
 
-void SetBmp(void) {
-    int id, cond;
-    cond = STACK_ERR_FULL;
+    temp1 = PopDs(&cond);
+    temp2 = PopDs(&cond);
 
-    id = PopDs(&cond);
-    lcd_bmp = true;
     if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
-        lcd_bmp_id = -1;
-        return ;
+        return;
     }
 
-    lcd_bmp_id = id;
+    (~((cell)1 << temp1)) & temp2 ? PushDs(FORTH_TRUE, &cond):PushDs(FORTH_FALSE, &cond);
+
 }
 
 /**
-* this word deletes all the GUI elements.
+* This function emits a new line
 */
-
-void ClearGui(void) {
-    RmGuiElemAll();
+void Cr(void) {
+    printf ("\n");
 }
 
 /**
-* This word provides access to the SPI bus
+* Waits until all of the output went out. The board buffers the console output
+* and sends it in the background, see console.c
 */
+void Flush(void) {
+    fflush(stdout);
+    FlushConsole();
+}
 
-void SpiWrite(void) {
-    SPI spi(p11, p12, p13);
-    DigitalOut cs(p14);
-    int cond, i, data, bits, no_bytes, mode, freq;
 
+/**
+ * Executes the ticker word
+ *
+ * The ticker interrupt only flags that the word is due. The inner interpreter keeps the top of the data stack
+ * in a register, so running Forth from the interrupt would see a stale stack. The word is run from
+ * ServiceTicker() instead, which is called on backward branches, when a word returns and while waiting for
+ * input or events.
+ */
 
-    freq = PopDs(&cond);
-    if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
+char ticker_cb[20];            /*< Ticker callback word name */
+cell ticker_xt;                /*< Execution token of the ticker callback word, 0 until it is first looked up */
+Ticker tickWord;               /*< Ticker */
+volatile int TickPending = FALSE;
+
+void CallBackTick(void) {
+    TickPending = TRUE;
+}
+
+void ServiceTicker(void) {
+    int depth;
+
+    if (!TickPending) {
         return;
     }
+    TickPending = FALSE;
 
-    mode = PopDs(&cond);
-    mode = mode>3?0:mode;      // let mode default to 0 in case of invalid mode
-    if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
+    if (ticker_xt == 0 && Find(ticker_cb, &ticker_xt) == FORTH_WORD_NOT_FOUND) {
+        // not defined yet, try again on the next tick
+        ticker_xt = 0;
         return;
     }
-    bits = PopDs(&cond);
-    if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
+
+    depth = DatStackTop;
+    if (Execute(ticker_xt) == STOP_FORTH_INTERPRET) {
+        // error while executing the word
+        tickWord.detach();
+    }
+    DatStackTop = depth;            // verified words rely on the depth they were entered with
+
+}
+
+/**
+ * Adds a ticker word
+ *
+ * The word is looked up on the first tick, the word may be defined after the ticker is set up. Later ticks
+ * execute it straight away.
+ */
+
+void AddTicker(void) {
+    int del, cond;
+    if (Word(ticker_cb, sizeof(ticker_cb)) == WORD_TOO_LONG) {
         return;
     }
-    if (bits != 16 && bits != 8) {
-        bits = 8;                // defualt to 8-bit mode
+
+    if (ticker_cb[0] == '\0') {
+        printf ("\nPlease specify a callback word for the ticker ");
+        return;
     }
+    ToUp(ticker_cb);
 
-    no_bytes = PopDs(&cond);
+    del = PopDs(&cond);
     if (cond == STACK_ERR_EMPTY) {
-        printf (ERR_TABLE[INSUFF_PARAMS]);
+        printf ("\nThis word requires delay in seconds to be pushed onto stack ");
         return;
     }
-    spi.format(bits, mode);
-    spi.frequency(freq);
 
+    // else
+    ticker_xt = 0;
+    tickWord.attach(&CallBackTick, del);       // no real delays
+
+}
 
-    cs = 0;
-    for (i=0; i<no_bytes; i++) {
-        data = PopDs(&cond);
-        if (cond == STACK_ERR_EMPTY) {
-            cs = 1;
-            return ;          // no data in the stack to write
-        }
-        spi.write(data);
+/**
+ * Forgets the execution tokens of ticker and button words which are no longer in the dictionary, called after
+ * FORGET. They are looked up by name again when next needed.
+ */
+
+void DropCallbacks(void) {
+    if ((char*)ticker_xt >= DicHere) {
+        ticker_xt = 0;
     }
-    cs = 1;               // deselct the spi device
+    DropIoCallbacks();
 }
 
+extern int skip_flag;
+
+/**
+* Loads a file from the sd card and executes it
+*/
+
+void Fload(void) {
+    char file_name[40];
+    int res;
 
+    skip_flag = 1;
+    res = Word(file_name, sizeof(file_name));
+    skip_flag = 0;
+    if (res == WORD_TOO_LONG) {
+        return ;
+    }
+    if (file_name[0] == '\0') {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        return ;
+    }
+
+    ReplaceQuotes(file_name);
+
+    res = ExecFromFile(file_name);
+
+    if (res == FILE_NOT_FOUND) {
+        printf (ERR_TABLE[COULD_NOT_FIND_FILE]);
+        printf ("%s", file_name);
+    }
+}
+
+/**
+* Saves the words defined so far into an image on the sd card, see InitExec()
+* ( save-image "file_name" )
+*/
+
+void SaveImageWord(void) {
+    char file_name[40];
+    int res;
+
+    skip_flag = 1;
+    res = Word(file_name, sizeof(file_name));
+    skip_flag = 0;
+    if (res == WORD_TOO_LONG) {
+        return ;
+    }
+    if (file_name[0] == '\0') {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        return ;
+    }
+
+    ReplaceQuotes(file_name);
+
+    res = SaveImageFile(file_name);
+    if (res == IMAGE_OK) {
+        printf ("Saved image %s \n", file_name);
+    } else {
+        printf ("Could not save image %s (error %d) \n", file_name, res);
+    }
+}
@@ -33,11 +33,37 @@
 #ifndef __FORTH_FUNC_H
 #define __FORTH_FUNC_H
 
-#define ARCHITECTURE      4                   /**< 32 bit architecture */
+#include "types.h"
+
+#define ARCHITECTURE      ((int)sizeof(cell)) /**< Characters packed into a cell by ." */
 #define FORTH_TRUE         -1                   /**< True is -1 in Forth */
 #define FORTH_FALSE          0                      /**< False is 0 in Forth */
 
 #define  PORT_OFFSET        5                  /**< Port offset for indexing port names */
+#define  STR_MAX           30                  /**< Longest string STR hands to \a StrSink, same as MAX_TXT of the GUI */
+
+#define  CASE_CLAUSES      64                  /**< Most OFs in the CASEs open at a time */
+#define  CASE_TABLE_MIN     3                  /**< Fewest OFs a CASE needs to be compiled to a jump table */
+#define  CASE_TABLE_FILL    2                  /**< A jump table may have up to this many entries per OF */
+
+#define  ARM_LIVE          -1                  /**< Left by IF on a literal for ELSE and THEN, the arm always runs */
+#define  ARM_DEAD(at)      (-2 - (at))         /**< The arm from \a at never runs and is dropped, ARM_DEAD() undoes it */
+
+#define  CTRL_ORIG          1                  /**< Tags what IF, ELSE and WHILE leave for ELSE, THEN and REPEAT to patch */
+#define  CTRL_DEST          2                  /**< Tags where BEGIN is for UNTIL, WHILE, AGAIN and REPEAT */
+#define  CTRL_DO            3                  /**< Tags what DO and ?DO leave for LOOP and +LOOP */
+#define  CTRL_CASE          4                  /**< Tags what CASE leaves for OF, ENDOF and ENDCASE */
+
+#define  INSUFF_PARAMS    0                    /**< Indices into \a ERR_TABLE */
+#define  GUI_NOT_FOUND    1
+#define  INVALID_PORT     2
+#define  COULD_NOT_FIND_FILE 3
+#define  COULD_NOT_ADD_GUI   4
+
+extern const char ERR_TABLE[][50];
+extern void (*StrSink)(char* str);             /**< Where STR sends its string next, stdout if NULL */
+
+extern volatile int TickPending;               /**< Set by the ticker interrupt, cleared by ServiceTicker() */
 
 
 
@@ -57,8 +83,19 @@ void Over(void);
 void DummyBus(void);
 void BaseSet(void);
 void Create(void);
+void Here(void);
+void Allot(void);
+void Comma(void);
+void CComma(void);
+void Forget(void);
+void ForgetXt(void);
+void Marker(void);
 void Read(void);
 void Write (void);
+void CFetch(void);
+void CStore(void);
+void Cells(void);
+void Cycles(void);
 void QueryBase(void);
 void CondBranch(void);
 void UnCondBranch(void);
@@ -67,6 +104,32 @@ void Then(void);
 void Else(void);
 void Begin(void);
 void Until(void);
+void While(void);
+void Again(void);
+void Repeat(void);
+void Recurse(void);
+void StartDefinition(void);
+void Do(void);
+void QueryDo(void);
+void Loop(void);
+void PlusLoop(void);
+void CompileI(void);
+void CompileJ(void);
+void Leave(void);
+void Unloop(void);
+void DoParams(void);
+void QueryDoParams(void);
+void LoopBranch(void);
+void PlusLoopBranch(void);
+void LoopIndex(void);
+void OuterIndex(void);
+void UnloopParams(void);
+void Case(void);
+void Of(void);
+void EndOf(void);
+void EndCase(void);
+void CaseBranch(void);
+void TailCall(void);
 void Equal (void);
 void GT (void);
 void LT (void);
@@ -74,6 +137,8 @@ void LTE (void);
 void GTE (void);
 void Drop(void);
 void StopCompile(void);
+void Inline(void);
+void NoInline(void);
 void DotStr(void);
 void DispStr(void);
 void SkipComment1(void);
@@ -85,15 +150,26 @@ void Xor(void);
 void BitSet(void);
 void BitClear(void);
 void Cr(void);
+void Flush(void);
+void DotFused(void);
+void LitAdd(void);
+void LitFetch(void);
+void DupMul(void);
+void ZeroEqBranch(void);
+void TwoDup(void);
+void AddTicker(void);
+void ServiceTicker(void);
+void DropCallbacks(void);
+void Fload(void);
+void SaveImageWord(void);
 
+/* forthIO.cpp, the words driving the GUI and the peripherals of the board */
 
-
+void DropIoCallbacks(void);
+ucell ReadCycles(void);
+void FlushConsole(void);                       /* console.c on the board */
 void DelayInSec(void);
-
-
-
 void MainLoop(void);
-void AddTicker(void);
 void CreateBtn(void);
 void ShowWidgets(void);
 void CreatePBar(void);
@@ -106,7 +182,6 @@ void ReadPort(void);
 void AnalogRead(void);
 void AnalogWrite(void);
 void ExitMainLoop(void);
-void Fload(void);
 void AddBmp(void);
 void SetBmp(void);
 void ClearGui(void);
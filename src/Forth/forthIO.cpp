@@ -0,0 +1,695 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       forthIO.cpp
+ * \brief      Words driving the GUI and the peripherals of the board
+ *
+ *             These are left out of the host build, everything else in forthFunctions.cpp runs on any machine.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "mbed.h"
+#include "interprter.h"
+#include "forthFunctions.h"
+#include "CoreForth.h"
+#include "stack.h"
+#include "types.h"
+#include "gui.h"
+#include "utils.h"
+
+
+
+#define  GEN_SIZE         20
+
+#define  DWT_CTRL         (*(volatile unsigned int*)0xE0001000)     /**< Cortex-M3 data watchpoint and trace unit */
+#define  DWT_CYCCNT       (*(volatile unsigned int*)0xE0001004)
+#define  DEMCR            (*(volatile unsigned int*)0xE000EDFC)     /**< Debug exception and monitor control */
+#define  DEMCR_TRCENA     (1 << 24)
+#define  DWT_CYCCNTENA    (1 << 0)
+
+int lcd_st_id;                    /**< The word resposnisble for setting text of a string should load approporiate id to this variable */
+int lcd_bmp_id;                  /**< Same as \a lcd_st_id but works on bit map */
+
+
+/**
+* The GUI and peripheral words, looked up after those of \a RomDic, see FORTH_IO_WORDS in words.h
+*/
+
+static const struct Node IoTable[] = {
+    FORTH_IO_WORDS(ROM_WORD)
+};
+
+const struct Node* const IoDic = IoTable;
+const int IoWords = sizeof(IoTable) / sizeof(IoTable[0]);
+
+/**
+* Forgets the execution tokens of button words which are no longer in the dictionary, see DropCallbacks()
+*/
+
+void DropIoCallbacks(void) {
+    DropBtnCallbacks(DicHere);
+}
+
+/**
+ *
+ * \fn        ReadCycles(void)
+ * \brief     Reads the cycle counter of the DWT unit, the counter is started on the first call
+ *
+ * \return    CPU cycles, wraps around every 2^32 cycles
+ *
+ */
+
+ucell ReadCycles(void) {
+    if (!(DWT_CTRL & DWT_CYCCNTENA)) {
+        DEMCR |= DEMCR_TRCENA;
+        DWT_CYCCNT = 0;
+        DWT_CTRL |= DWT_CYCCNTENA;
+    }
+    return DWT_CYCCNT;
+}
+
+/**
+ *  \fn     DelayInSec(void)
+ *  \brief  Delays execution in seconds, obtained from data stack
+ */
+
+void DelayInSec(void) {
+    int temp, cond;
+
+    temp = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        return;
+    }
+
+    wait(temp);
+
+}
+
+/**
+*   This function causes the execution to come out of the main loop
+*/
+
+bool exit_ml = false;
+
+void ExitMainLoop(void) {
+    exit_ml = true;
+}
+
+/**
+ *  \fn         MainLoop(void)
+ *  \brief      Word call back
+ *
+ *              Waits for button events and executes the word attached to the button. Ticker words are run in between.
+*/
+
+void MainLoop(void) {
+    int ret, id;
+    btn *btn_info;
+
+    while (1) {
+
+        ret = NO_EVENT;
+        while (ret != EVENT) {
+            // wait for an event
+            ServiceTicker();
+            ret = Dispatcher(&btn_info, &id);
+        }
+
+        if (btn_info->call_back_xt == 0) {
+            // first press, the word may have been defined after the button
+            if (Find(btn_info->call_back_word, &btn_info->call_back_xt) == FORTH_WORD_NOT_FOUND) {
+                printf ("Word %s not found \n", btn_info->call_back_word);
+                btn_info->call_back_xt = 0;
+            }
+        }
+
+        if (btn_info->call_back_xt != 0) {
+            Execute(btn_info->call_back_xt);    // execute the call back word
+        }
+
+        if (exit_ml == true) {
+            exit_ml = false;            // ready the flag for next round
+            break;
+        }
+    }
+
+}
+
+
+/**
+ * Creates a button with given parameters.
+ * On stack, the parameter list is x, y id crt_btn "button_name" "button_lbl" call_back_wrd
+ */
+
+extern int skip_flag;
+void CreateBtn(void) {
+    int cond = STACK_ERR_FULL;
+    int id, x, y;
+    char btn_name[GEN_SIZE], btn_lbl[GEN_SIZE], cb_wrd[MAX_WRD_SIZE];
+
+    id = PopDs(&cond);
+    y = PopDs(&cond);
+    x = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    // get button_name and button_label
+    skip_flag = 1;
+    cond = Word(btn_name, sizeof(btn_name));
+    skip_flag = 0;
+    if (cond == WORD_TOO_LONG) {
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    if (btn_name[0] == '\0') {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    skip_flag = 1;
+    cond = Word(btn_lbl, sizeof(btn_lbl));
+    skip_flag = 0;
+    if (cond == WORD_TOO_LONG) {
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    if (btn_lbl[0] == '\0') {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+
+    if (Word(cb_wrd, sizeof(cb_wrd)) == WORD_TOO_LONG) {
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    if (cb_wrd[0] == '\0') {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+
+    ReplaceQuotes(btn_lbl);
+    ReplaceQuotes(btn_name);
+    ToUp(cb_wrd);
+    cond = AddButton(id, btn_lbl, btn_name, cb_wrd, x, y);
+    if (cond == ERR_ERROR) {
+        printf (ERR_TABLE[COULD_NOT_ADD_GUI]);
+        ErrorCond(FORTH_FALSE);
+    }
+    ErrorCond(FORTH_TRUE);
+}
+
+/**
+ * Lays out all the GUI elements
+ */
+
+void ShowWidgets(void) {
+    DrawControls();
+}
+
+/**
+*  This word adds a progress bar to the widget list
+*/
+
+void CreatePBar(void) {
+    int id, cond, x, y;
+    char p_name[GEN_SIZE];
+    cond = STACK_ERR_FULL;
+
+    id = PopDs(&cond);
+    y = PopDs(&cond);
+    x = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    // get button_name and button_label
+    skip_flag = 1;
+    cond = Word(p_name, sizeof(p_name));
+    skip_flag = 0;
+    if (cond == WORD_TOO_LONG) {
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    if (p_name[0] == '\0') {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+
+    ReplaceQuotes(p_name);
+    cond = AddPBar(id, p_name, x, y);
+    if (cond == ERR_ERROR) {
+        printf (ERR_TABLE[COULD_NOT_ADD_GUI]);
+        ErrorCond(FORTH_FALSE);
+    }
+    ErrorCond(FORTH_TRUE);
+}
+
+/**
+*  This function sets volume for a progress bar
+*/
+
+void SetPBar(void) {
+    int id, cond, vol;
+    cond = STACK_ERR_FULL;
+    id = PopDs(&cond);
+    vol = PopDs(&cond);
+
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    cond = SetPBar(id, vol);
+
+    if (cond == ERR_ERROR) {
+        printf (ERR_TABLE[GUI_NOT_FOUND]);
+        printf ("%d", id);
+        ErrorCond(FORTH_FALSE);
+    }
+    ErrorCond(FORTH_TRUE);
+}
+
+/**
+*  This function creates a static text control
+*  f_Color b_bolor x y id crt_sttxt name text
+*/
+
+extern int *color_table;
+
+void CreateStTxt(void) {
+    int id, cond, x, y, f_clr, b_clr;
+    char txt_name[GEN_SIZE], txt[GEN_SIZE];
+    cond = STACK_ERR_FULL;
+
+    id = PopDs(&cond);
+    y = PopDs(&cond);
+    x = PopDs(&cond);
+    b_clr = PopDs(&cond);
+    f_clr = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+
+    f_clr = ColorVal(f_clr);
+    b_clr = ColorVal(b_clr);
+    // get name and text
+    skip_flag = 1;
+    cond = Word(txt_name, sizeof(txt_name));
+    skip_flag = 0;
+    if (cond == WORD_TOO_LONG) {
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    if (txt_name[0] == '\0') {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    skip_flag = 1;
+    cond = Word(txt, sizeof(txt));
+    skip_flag = 0;
+    if (cond == WORD_TOO_LONG) {
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    if (txt[0] == '\0') {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+
+    ReplaceQuotes(txt_name);
+    ReplaceQuotes(txt);
+    cond = AddStText(id, txt_name, x, y, txt, f_clr, b_clr);
+
+    if (cond == ERR_ERROR) {
+        printf (ERR_TABLE[COULD_NOT_ADD_GUI]);
+        ErrorCond(FORTH_FALSE);
+    }
+    ErrorCond(FORTH_TRUE);
+}
+
+/**
+* This function sets a text for static text control
+* id set_st_txt ." text "
+*/
+
+static void StTxtSink(char* str) {
+    if (lcd_st_id != -1) { // no error
+        SetStText(lcd_st_id, str);
+    }
+}
+
+void SetStTxt(void) {
+    int cond;
+    StrSink = &StTxtSink;
+    lcd_st_id = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        lcd_st_id = -1;
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+
+}
+
+/**
+*  This function sets fore groud color and back ground color of a static text
+*/
+
+void SetStClr(void) {
+    int id, cond, f_clr, b_clr;
+    cond = STACK_ERR_FULL;
+
+    id = PopDs(&cond);
+    b_clr = PopDs(&cond);
+    f_clr = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+
+    f_clr = ColorVal(f_clr);
+    b_clr = ColorVal(b_clr);
+
+    id = SetStColor(id, f_clr, b_clr);
+
+    if (id == ERR_ERROR) {
+        printf (ERR_TABLE[GUI_NOT_FOUND]);
+        printf ("%d", id);
+        ErrorCond(FORTH_FALSE);
+    }
+    ErrorCond(FORTH_TRUE);
+}
+
+
+/**
+* This function writes a digital value to given port pin
+* ( port_val port_position DigitalOut -- )
+*
+* @note  On mbed thereare port form 5 to 30 so valid port_position are from 5 to 30 (inclusive of both)
+*        and for accessing led1-led4, the valid port_positions are 31, 32, 33 and 34
+*/
+
+void SetPort(void) {
+    int cond, port_val, port_index;
+    DigitalOut ports[] = {p9, p9, p9, p9, p9, p10, p11, p12, p13, p14, p15, p16, p17, p18, p19, p20,
+                          p21, p22, p23, p24, p25, p26, p27, p28, p29, LED1, LED1, LED2, LED3, LED4
+                         };
+
+    int max=sizeof(ports)/sizeof(DigitalOut);
+
+    cond = STACK_ERR_FULL;
+
+    port_index = PopDs(&cond);
+    port_val = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        return ;
+    }
+
+    port_index = port_index - PORT_OFFSET;       // to index the array elements properly
+
+    if (port_index < 0 || port_index >= max) {
+        printf (ERR_TABLE[INVALID_PORT]);
+        return ;
+    }
+    // set the port values
+    if (port_val == 0) {
+        ports[port_index] = 0;
+    } else {
+        ports[port_index] = 1;
+    }
+}
+
+/**
+* This function reads digital logic level at a given port and pushes either 1 or
+* 0 on to stack depending on the logic voltage at that pin
+* ( port_position DigitalIn -- logic_level_at_that_port )
+*
+*/
+
+void ReadPort(void) {
+    int cond, port_val, port_index;
+    DigitalOut ports[] = {p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15, p16, p17, p18, p19, p20,
+                          p21, p22, p23, p24, p25, p26, p27, p28, p29, p30
+                         };
+
+    int max=sizeof(ports)/sizeof(DigitalOut);
+
+    cond = STACK_ERR_FULL;
+
+    port_index = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        return ;
+    }
+
+    port_index = port_index - PORT_OFFSET;       // to index the array elements properly
+
+    if (port_index < 0 || port_index >= max) {
+        printf (ERR_TABLE[INVALID_PORT]);
+        return ;
+    }
+    port_val = ports[port_index];
+    PushDs(port_val, &cond);
+}
+
+/**
+* Reads analog voltage at a given pin and pushes the value onto stack
+* ( ch_index DigitalIn -- read_value )
+*  channel 0-4 p15-p20
+*/
+
+void AnalogRead(void) {
+    int cond, channel;
+    AnalogIn ain_channels[] = {p15, p16, p17, p18, p19};
+
+    int max=sizeof(ain_channels)/sizeof(DigitalOut);
+
+    cond = STACK_ERR_FULL;
+
+    channel = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        return ;
+    }
+
+    if (channel < 0 || channel >= max) {
+        printf (ERR_TABLE[INVALID_PORT]);
+        return ;
+    }
+
+    channel =  ain_channels[channel];
+    PushDs(channel, &cond);
+}
+
+/**
+* Outputs a given analog value at p18 pin
+*/
+
+void AnalogWrite(void) {
+    int cond, aout_val;
+    AnalogOut aout(p18);
+
+    cond = STACK_ERR_FULL;
+
+    aout_val = PopDs(&cond);
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        return ;
+    }
+
+    aout = aout_val;
+}
+
+/**
+* Creates a bit map control.
+* ( x y id crt_bmp "name" "file_name" )
+*/
+
+void AddBmp(void) {
+    int id, cond, x, y;
+    char bmp_name[GEN_SIZE], file_loc[GEN_SIZE];
+    cond = STACK_ERR_FULL;
+
+    id = PopDs(&cond);
+    y = PopDs(&cond);
+    x = PopDs(&cond);
+
+
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+
+    // get name and text
+    skip_flag = 1;
+    cond = Word(bmp_name, sizeof(bmp_name));
+    skip_flag = 0;
+    if (cond == WORD_TOO_LONG) {
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    if (bmp_name[0] == '\0') {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    skip_flag = 1;
+    cond = Word(file_loc, sizeof(file_loc));
+    skip_flag = 0;
+    if (cond == WORD_TOO_LONG) {
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+    if (file_loc[0] == '\0') {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        ErrorCond(FORTH_FALSE);
+        return ;
+    }
+
+    ReplaceQuotes(bmp_name);
+    ReplaceQuotes(file_loc);
+    if (AddBMP(id, bmp_name, x, y, file_loc) == ERR_ERROR) {
+        printf ("\nError Adding BMP control ");
+        ErrorCond(FORTH_FALSE);
+        return;
+    }
+    ErrorCond(FORTH_TRUE);
+
+}
+
+/**
+* Given an id, this function chages the source fr bit map data and
+* redraws it. This function actually sets the flags for STR word.
+*/
+
+static void BmpSink(char* str) {
+    if (lcd_bmp_id != -1 ) {
+        UpdateBMP(lcd_bmp_id, str);
+    }
+}
+
+void SetBmp(void) {
+    int id, cond;
+    cond = STACK_ERR_FULL;
+
+    id = PopDs(&cond);
+    StrSink = &BmpSink;
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        lcd_bmp_id = -1;
+        return ;
+    }
+
+    lcd_bmp_id = id;
+}
+
+/**
+* this word deletes all the GUI elements.
+*/
+
+void ClearGui(void) {
+    RmGuiElemAll();
+}
+
+/**
+* This word provides access to the SPI bus
+*/
+
+void SpiWrite(void) {
+    SPI spi(p11, p12, p13);
+    DigitalOut cs(p14);
+    int cond, i, data, bits, no_bytes, mode, freq;
+
+
+    freq = PopDs(&cond);
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        return;
+    }
+
+    mode = PopDs(&cond);
+    mode = mode>3?0:mode;      // let mode default to 0 in case of invalid mode
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        return;
+    }
+    bits = PopDs(&cond);
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        return;
+    }
+    if (bits != 16 && bits != 8) {
+        bits = 8;                // defualt to 8-bit mode
+    }
+
+    no_bytes = PopDs(&cond);
+    if (cond == STACK_ERR_EMPTY) {
+        printf (ERR_TABLE[INSUFF_PARAMS]);
+        return;
+    }
+    spi.format(bits, mode);
+    spi.frequency(freq);
+
+
+    cs = 0;
+    for (i=0; i<no_bytes; i++) {
+        data = PopDs(&cond);
+        if (cond == STACK_ERR_EMPTY) {
+            cs = 1;
+            return ;          // no data in the stack to write
+        }
+        spi.write(data);
+    }
+    cs = 1;               // deselct the spi device
+}
+
+
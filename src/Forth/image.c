@@ -0,0 +1,446 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       image.c
+ * \brief      Saves the user dictionary into a binary image and loads it back
+ *
+ *             Loading an image is a copy plus a pass over the relocation table, much quicker than compiling the
+ *             scripts again. Everything from the dictionary fence up to HERE goes into the image: the entries,
+ *             their code, variables and ALLOTed space. The cells holding addresses are listed in the relocation
+ *             table so that the image can be loaded at a different address or on a firmware with the inbuilt
+ *             words at different places:
+ *
+ *             - the links and code pointers of the entries
+ *             - every word compiled into a definition
+ *             - operands of LIT, (LIT+) and (LIT@) which point into the image, e.g VARIABLEs
+ *
+ *             With FORTH_TOKEN_CODE the words compiled into a definition are tokens, relocated with RELOC_TOKEN
+ *             added to their kind. The tokens of the primitives stay as they are.
+ *
+ *             Addresses stored into variables or ALLOTed space at run time are saved as they are.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "CoreForth.h"
+#include "interprter.h"
+#include "optimise.h"
+#include "token.h"
+#include "image.h"
+
+static NodePtr Inbuilt[IMAGE_MAX_INBUILT];  /**< Inbuilt words the image refers to, saved by name */
+static int InbuiltCnt;                      /**< Number of entries in \a Inbuilt */
+static int RelocCnt;                        /**< Number of relocations found by WalkRelocs() */
+
+
+/**
+ *
+ * \fn          ImageChecksum(unsigned int sum, const void* buff, int len)
+ * \brief       Adds a buffer to a running checksum (FNV-1a), start with IMAGE_SUM_INIT
+ *
+ */
+
+unsigned int ImageChecksum(unsigned int sum, const void* buff, int len) {
+    const unsigned char* p = (const unsigned char*)buff;
+
+    while (len-- > 0) {
+        sum = (sum ^ *p++) * 16777619u;
+    }
+
+    return sum;
+}
+
+
+/**
+ *
+ * \fn          InImage(cell addr)
+ * \brief       Tells if an address lies within the part of the dictionary that goes into the image
+ *
+ */
+
+static int InImage(cell addr) {
+    return (char*)addr >= DicFence && (char*)addr < DicHere;
+}
+
+
+/**
+ *
+ * \fn          XtKind(cell xt)
+ * \brief       Returns the relocation kind for a compiled word, -3 if there are too many inbuilt words
+ *
+ */
+
+static int XtKind(cell xt) {
+    int i;
+
+    if (InImage(xt)) {
+        return RELOC_IMAGE;
+    }
+
+    for (i=0; i<InbuiltCnt; i++) {
+        if (Inbuilt[i] == (NodePtr)xt) {
+            return i;
+        }
+    }
+
+    if (InbuiltCnt == IMAGE_MAX_INBUILT) {
+        return -3;
+    }
+    Inbuilt[InbuiltCnt] = (NodePtr)xt;
+    return InbuiltCnt++;
+}
+
+
+/**
+ *
+ * \fn          EmitReloc(FILE* fp, unsigned int* sum, void* at, int kind)
+ * \brief       Writes a relocation entry, only counts it if fp is NULL
+ *
+ */
+
+static int EmitReloc(FILE* fp, unsigned int* sum, void* at, int kind) {
+    struct ImageReloc reloc;
+
+    RelocCnt++;
+    if (fp == NULL) {
+        return IMAGE_OK;
+    }
+
+    reloc.at = (char*)at - DicFence;
+    reloc.kind = kind;
+    *sum = ImageChecksum(*sum, &reloc, sizeof(reloc));
+
+    return fwrite(&reloc, sizeof(reloc), 1, fp) == 1 ? IMAGE_OK : IMAGE_ERR_IO;
+}
+
+
+/**
+ *
+ * \fn          WalkCode(FILE* fp, unsigned int* sum, cell* code)
+ * \brief       Finds the addresses in the code of an entry, see WalkRelocs()
+ *
+ */
+
+#if FORTH_TOKEN_CODE
+
+static int WalkCode(FILE* fp, unsigned int* sum, cell* code) {
+    code_unit *ip, *end = (code_unit*)DicHere;
+    int kind, prim, ret = IMAGE_OK;
+
+    for (ip=(code_unit*)code; ip<end && *ip != END_CODE && ret == IMAGE_OK; ip += 1 + OperandUnits(ip)) {
+        prim = PRIM_BASE(TOKEN_NODE(*ip)->prim);
+        if (*ip >= TOKEN_CALL) {
+            kind = XtKind((cell)TOKEN_NODE(*ip));
+            if (kind == -3) {
+                return IMAGE_ERR_WORD;
+            }
+            ret = EmitReloc(fp, sum, ip, RELOC_TOKEN + kind);
+        } else if ((prim == PRIM_LIT || prim == PRIM_LIT_ADD || prim == PRIM_LIT_FETCH) && InImage(CODE_CELL(ip+1))) {
+            ret = EmitReloc(fp, sum, ip+1, RELOC_IMAGE);
+        } else if (prim == PRIM_TAIL) {
+            kind = XtKind((cell)CODE_XT(ip+1));
+            if (kind == -3) {
+                return IMAGE_ERR_WORD;
+            }
+            ret = EmitReloc(fp, sum, ip+1, RELOC_TOKEN + kind);
+        }
+    }
+
+    return ret;
+}
+
+#else
+
+static int WalkCode(FILE* fp, unsigned int* sum, cell* code) {
+    int i, n, len, kind, prim, ret = IMAGE_OK;
+
+    len = (cell*)DicHere - code;
+    for (i=0; i<len && code[i] != END_WORD && ret == IMAGE_OK; i += 1 + n) {
+        kind = XtKind(code[i]);
+        if (kind == -3) {
+            return IMAGE_ERR_WORD;
+        }
+        ret = EmitReloc(fp, sum, &code[i], kind);
+
+        n = OperandCells(code, i, len);
+        prim = PRIM_BASE(((NodePtr)code[i])->prim);
+        if (n == 1 && (prim == PRIM_LIT || prim == PRIM_LIT_ADD || prim == PRIM_LIT_FETCH) && InImage(code[i+1])) {
+            ret = EmitReloc(fp, sum, &code[i+1], RELOC_IMAGE);
+        } else if (n == 1 && prim == PRIM_TAIL && ret == IMAGE_OK) {
+            kind = XtKind(code[i+1]);                   // the word called, relocated like any other
+            if (kind == -3) {
+                return IMAGE_ERR_WORD;
+            }
+            ret = EmitReloc(fp, sum, &code[i+1], kind);
+        }
+    }
+
+    return ret;
+}
+
+#endif
+
+
+/**
+ *
+ * \fn          WalkRelocs(FILE* fp, unsigned int* sum)
+ * \brief       Finds every cell of the user dictionary which holds an address
+ *
+ *              The first walk is done with fp NULL to collect the inbuilt words and count the relocations, the
+ *              second one writes them out.
+ *
+ */
+
+static int WalkRelocs(FILE* fp, unsigned int* sum) {
+    NodePtr node;
+    int kind, ret = IMAGE_OK;
+
+    RelocCnt = 0;
+
+    for (node = LATEST; node != NULL && (char*)node >= DicFence && ret == IMAGE_OK; node = node->next) {
+        kind = (char*)node->next >= DicFence ? RELOC_IMAGE : RELOC_LATEST;
+        ret = EmitReloc(fp, sum, &node->next, kind);
+
+        if (node->code == NULL || ret != IMAGE_OK) {
+            continue;
+        }
+        ret = EmitReloc(fp, sum, &node->code, RELOC_IMAGE);
+        if (ret == IMAGE_OK) {
+            ret = WalkCode(fp, sum, node->code);
+        }
+    }
+
+    return ret;
+}
+
+
+/**
+ *
+ * \fn          SaveImage(FILE* fp, struct ImageSource* source, int sources)
+ * \brief       Writes the user dictionary into an image file
+ *
+ * \param[in]   fp       file opened for binary writing
+ * \param[in]   source   scripts the dictionary was compiled from, kept in the header
+ * \param[in]   sources  number of scripts, more than IMAGE_MAX_SOURCES if not all of them were recorded
+ *
+ * \return      IMAGE_OK or one of the IMAGE_ERR codes
+ *
+ */
+
+int SaveImage(FILE* fp, struct ImageSource* source, int sources) {
+    struct ImageHeader hdr;
+    char name[FORTH_NAMEMAX];
+    unsigned int sum = IMAGE_SUM_INIT;
+    int i, ret;
+
+    InbuiltCnt = 0;
+    ret = WalkRelocs(NULL, NULL);
+    if (ret != IMAGE_OK) {
+        return ret;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = IMAGE_MAGIC;
+    hdr.version = IMAGE_VERSION;
+    hdr.cell_size = sizeof(cell);
+    hdr.node_size = sizeof(struct Node);
+    hdr.unit_size = sizeof(code_unit);
+    hdr.base = (cell)DicFence;
+    hdr.arena = (cell)DicArena;
+    hdr.size = DicHere - DicFence;
+    hdr.latest = (char*)LATEST >= DicFence ? (char*)LATEST - DicFence : -1;
+    hdr.inbuilt = InbuiltCnt;
+    hdr.relocs = RelocCnt;
+    hdr.sources = sources;
+    memcpy(hdr.source, source, (sources < IMAGE_MAX_SOURCES ? sources : IMAGE_MAX_SOURCES) * sizeof(struct ImageSource));
+
+    if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1) {      // written again once the checksum is known
+        return IMAGE_ERR_IO;
+    }
+
+    for (i=0; i<InbuiltCnt; i++) {
+        memset(name, 0, sizeof(name));                  // the padding goes into the checksum too
+        snprintf(name, sizeof(name), "%.*s", (int)sizeof(name) - 1, Inbuilt[i]->WrdName);
+        sum = ImageChecksum(sum, name, sizeof(name));
+        if (fwrite(name, sizeof(name), 1, fp) != 1) {
+            return IMAGE_ERR_IO;
+        }
+    }
+
+    sum = ImageChecksum(sum, DicFence, hdr.size);
+    if (hdr.size > 0 && fwrite(DicFence, hdr.size, 1, fp) != 1) {
+        return IMAGE_ERR_IO;
+    }
+
+    ret = WalkRelocs(fp, &sum);
+    if (ret != IMAGE_OK) {
+        return ret;
+    }
+
+    hdr.sum = sum;
+    if (fseek(fp, 0, SEEK_SET) != 0 || fwrite(&hdr, sizeof(hdr), 1, fp) != 1) {
+        return IMAGE_ERR_IO;
+    }
+
+    return IMAGE_OK;
+}
+
+
+/**
+ *
+ * \fn          ReadImageHeader(FILE* fp, struct ImageHeader* hdr)
+ * \brief       Reads the header of an image and checks that this firmware can load it
+ *
+ * \return      IMAGE_OK, IMAGE_ERR_IO or IMAGE_ERR_VERSION
+ *
+ */
+
+int ReadImageHeader(FILE* fp, struct ImageHeader* hdr) {
+    if (fread(hdr, sizeof(struct ImageHeader), 1, fp) != 1) {
+        return IMAGE_ERR_IO;
+    }
+
+    if (hdr->magic != IMAGE_MAGIC || hdr->version != IMAGE_VERSION || hdr->cell_size != sizeof(cell) ||
+            hdr->node_size != sizeof(struct Node) || hdr->unit_size != sizeof(code_unit) || hdr->inbuilt < 0 || hdr->inbuilt > IMAGE_MAX_INBUILT ||
+            hdr->size < 0 || hdr->relocs < 0) {
+        return IMAGE_ERR_VERSION;
+    }
+
+    return IMAGE_OK;
+}
+
+
+/**
+ *
+ * \fn          LoadImage(FILE* fp)
+ * \brief       Loads an image on top of the current dictionary
+ *
+ *              The image is copied to \a DicHere, padded so that the entries keep their alignment. Nothing is
+ *              linked into the dictionary until the whole file has been read and the checksum matched.
+ *
+ * \param[in]   fp   image file opened for binary reading
+ *
+ * \return      IMAGE_OK or one of the IMAGE_ERR codes
+ *
+ */
+
+int LoadImage(FILE* fp) {
+    struct ImageHeader hdr;
+    struct ImageReloc reloc;
+    char name[FORTH_NAMEMAX];
+    unsigned int sum = IMAGE_SUM_INIT;
+    char *base, *at;
+    int i, pad, ret, kind, size, missing = 0, bad = 0;
+    cell xt;
+#if FORTH_TOKEN_CODE
+    code_unit token;
+#endif
+
+    rewind(fp);
+    ret = ReadImageHeader(fp, &hdr);
+    if (ret != IMAGE_OK) {
+        return ret;
+    }
+
+    pad = (hdr.base - (cell)DicHere) & (sizeof(NodePtr) - 1);
+    if (hdr.size + pad > DicRoom()) {
+        return IMAGE_ERR_SPACE;
+    }
+    base = DicHere + pad;
+
+    for (i=0; i<hdr.inbuilt; i++) {
+        if (fread(name, sizeof(name), 1, fp) != 1) {
+            return IMAGE_ERR_IO;
+        }
+        sum = ImageChecksum(sum, name, sizeof(name));
+        name[FORTH_NAMEMAX-1] = '\0';
+        if (Find(name, &xt) == FORTH_WORD_NOT_FOUND) {
+            missing = 1;
+            xt = 0;
+        }
+        Inbuilt[i] = (NodePtr)xt;
+    }
+
+    if (hdr.size > 0 && fread(base, hdr.size, 1, fp) != 1) {
+        return IMAGE_ERR_IO;
+    }
+    sum = ImageChecksum(sum, base, hdr.size);
+
+    for (i=0; i<hdr.relocs; i++) {
+        if (fread(&reloc, sizeof(reloc), 1, fp) != 1) {
+            return IMAGE_ERR_IO;
+        }
+        sum = ImageChecksum(sum, &reloc, sizeof(reloc));
+
+        kind = reloc.kind;
+        size = sizeof(cell);
+#if FORTH_TOKEN_CODE
+        if (kind >= RELOC_TOKEN + RELOC_IMAGE) {
+            kind -= RELOC_TOKEN;
+            size = sizeof(code_unit);
+        }
+#endif
+        if (reloc.at < 0 || reloc.at > hdr.size - size || kind < RELOC_LATEST || kind >= hdr.inbuilt) {
+            bad = 1;                                // do not write outside the image
+            continue;
+        }
+
+        at = base + reloc.at;                       // operands of token code are not aligned to a cell
+        if (size == sizeof(cell)) {
+            memcpy(&xt, at, sizeof(cell));
+        } else {
+#if FORTH_TOKEN_CODE
+            memcpy(&token, at, sizeof(token));
+            xt = hdr.arena + (cell)(token - TOKEN_WORD) * (cell)sizeof(cell);
+#endif
+        }
+        if (kind == RELOC_IMAGE) {
+            xt = xt - hdr.base + (cell)base;
+        } else if (kind == RELOC_LATEST) {
+            xt = (cell)LATEST;
+        } else {
+            xt = (cell)Inbuilt[kind];
+        }
+        if (size == sizeof(cell)) {
+            memcpy(at, &xt, sizeof(cell));
+        } else if (xt != 0) {
+#if FORTH_TOKEN_CODE
+            token = TOKEN_OF((NodePtr)xt);
+            memcpy(at, &token, sizeof(token));
+#endif
+        }
+    }
+
+    if (bad || sum != hdr.sum) {
+        return IMAGE_ERR_CHECKSUM;
+    }
+    if (missing) {
+        return IMAGE_ERR_WORD;
+    }
+
+    AppendDicEntries(hdr.latest >= 0 ? (NodePtr)(base + hdr.latest) : LATEST, base + hdr.size);
+
+    return IMAGE_OK;
+}
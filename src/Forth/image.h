@@ -0,0 +1,111 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       image.h
+ * \brief      Binary images of the user dictionary
+ *
+ *             An image file is laid out as follows, all numbers in the byte order of the target:
+ *
+ *             struct ImageHeader
+ *             names of the inbuilt words the image refers to, FORTH_NAMEMAX bytes each
+ *             the dictionary arena from the fence up to HERE
+ *             relocation table, a struct ImageReloc for every cell holding an address and every token naming
+ *             a word
+ *
+ */
+
+#ifndef __IMAGE_H
+#define __IMAGE_H
+
+#include <stdio.h>
+#include "types.h"
+
+#define IMAGE_MAGIC          0x474d4946       /**< "FIMG" */
+#define IMAGE_VERSION        4                /**< Bump whenever the layout of the image, of struct Node or the inbuilt words change */
+#define IMAGE_MAX_SOURCES    4                /**< Source files remembered in an image */
+#define IMAGE_NAME_SIZE      24               /**< Maximum length of a source file name */
+#define IMAGE_MAX_INBUILT    160              /**< Maximum number of distinct inbuilt words an image can refer to */
+#define IMAGE_SUM_INIT       2166136261u      /**< Starting value for ImageChecksum() */
+
+#define RELOC_IMAGE          -1               /**< Cell holds an address within the image */
+#define RELOC_LATEST         -2               /**< Cell links to the dictionary the image is loaded on top of */
+#define RELOC_TOKEN          0x4000           /**< Added to the kind of a token naming a word, FORTH_TOKEN_CODE */
+                                              /**< Any other kind is the index of an inbuilt word in the name table */
+
+#define IMAGE_OK             0                /**< Image saved or loaded */
+#define IMAGE_ERR_IO         1                /**< Could not read or write the file */
+#define IMAGE_ERR_VERSION    2                /**< Not an image or made by a different version */
+#define IMAGE_ERR_CHECKSUM   3                /**< Image is corrupt */
+#define IMAGE_ERR_SPACE      4                /**< Image does not fit into the dictionary */
+#define IMAGE_ERR_WORD       5                /**< Image refers to an inbuilt word this firmware does not have */
+
+/**
+ * \struct      ImageSource
+ * \brief       A Forth script the image was compiled from
+ */
+
+struct ImageSource {
+    char name[IMAGE_NAME_SIZE];                 /**< File name relative to the SD card */
+    unsigned int sum;                           /**< ImageChecksum() of the file contents */
+};
+
+/**
+ * \struct      ImageHeader
+ * \brief       Start of an image file
+ */
+
+struct ImageHeader {
+    int magic;                                  /**< IMAGE_MAGIC */
+    int version;                                /**< IMAGE_VERSION */
+    int cell_size;                              /**< sizeof(cell) of the target which saved it */
+    int node_size;                              /**< sizeof(struct Node) of the target which saved it */
+    int unit_size;                              /**< sizeof(code_unit), cells or tokens */
+    cell base;                                  /**< Address the image was saved from */
+    cell arena;                                 /**< Address of the arena it was saved from, tokens count from there */
+    int size;                                   /**< Bytes of dictionary in the image */
+    int latest;                                 /**< Offset of the newest entry from base */
+    int inbuilt;                                /**< Number of inbuilt names */
+    int relocs;                                 /**< Number of relocation entries */
+    unsigned int sum;                           /**< ImageChecksum() of everything after the header */
+    int sources;                                /**< Number of entries in source, more than IMAGE_MAX_SOURCES if not all were kept */
+    struct ImageSource source[IMAGE_MAX_SOURCES];
+};
+
+/**
+ * \struct      ImageReloc
+ * \brief       A cell in the image which holds an address
+ */
+
+struct ImageReloc {
+    int at;                                     /**< Offset of the cell from base */
+    int kind;                                   /**< RELOC_IMAGE, RELOC_LATEST or index into the inbuilt names, plus
+                                                     RELOC_TOKEN for a token */
+};
+
+unsigned int ImageChecksum(unsigned int sum, const void* buff, int len);
+int SaveImage(FILE* fp, struct ImageSource* source, int sources);
+int ReadImageHeader(FILE* fp, struct ImageHeader* hdr);
+int LoadImage(FILE* fp);
+
+#endif
@@ -35,49 +35,62 @@
 #include "interprter.h"
 #include "CoreForth.h"
 #include "stack.h"
+#include "forthFunctions.h"
+#include "profile.h"
+#include "optimise.h"
+#include "token.h"
+#include "utils.h"
 
-int AddDicEntry(char* name, int ForthFlags, func_ptr func, int* CodeList, int len);
+int AddDicEntry(char* name, int ForthFlags, func_ptr func, cell* CodeList, int len);
 
 typedef struct Buffer Buffer;
 Buffer output;
 char HoldBuffer[200];
 
 int CmdPos;                                 /**< This variable holds the current position of word being parsed */
-char CmdBuff[BUFFER_SIZE];                  /**< Buffer used to hold the commands */
+char TermBuff[BUFFER_SIZE];                 /**< Buffer the console reads the commands into */
+char* CmdBuff = TermBuff;                   /**< Line being interpreted, TermBuff or a line of the script being loaded */
+int LineComment;                            /**< Set once a \ comment skipped the rest of the line */
 bool CompileMode = FALSE;                       /**< Flag to indicate compile mode in FORTH */
-int CurrentAddr;                            /**< Holds the current address of word being executed */
-int i_pc;                                   /**< Index for current address in a word */
+bool CompileFailed = FALSE;                 /**< Set with \a CompileMode cleared by a control word which could not compile */
+code_unit *IP;                              /**< Instruction pointer, points to the next code cell to be executed */
+#if FORTH_COUNT_INSNS
+unsigned long InsnCount;                    /**< Words dispatched by Execute() so far */
+#endif
 int BASE  = 10;                             /**< Holds current base system. Base 10 by default  */
-int CompileCode[FORTH_CODE_SIZE];           /**< To store compiled key words*/
+cell *CompileCode;                          /**< Code of the word being compiled, right in the dictionary arena */
 int j_pc;                                   /**< Points to current word that is being compiled within a word */
+int LitRun;                                 /**< Cells from here up to \a j_pc are literals the next word may be folded over */
 bool WrdNameFlag = FALSE;                   /**< To indicate that we already have the name */
 
 
 /**
  *
- * \fn         Word(char* wrd)
+ * \fn         Word(char* wrd, int size)
  * \brief      This function returns a word from current command buffer
  *
  *             Every successive call to this function will return next word in the command buffer.
+ *             A word that does not fit into \a size characters with its NUL is skipped and reported,
+ *             \a wrd is left empty.
  *
  * \param[out] wrd contains a extarcted word from the command buffer
- * \return     Number of words the function Word has extarcted
+ * \param[in]  size size of \a wrd
+ * \return     Number of words the function Word has extarcted, WORD_TOO_LONG if the word did not fit
  *
  */
 
 int skip_flag;               /**< To skip spaces within quotes */
-int Word (char* wrd) {
+int Word (char* wrd, int size) {
 
     int i=0;
     static int count;
     int space_flag = 0, q_flag = 0;
 
-    while (CmdBuff[CmdPos] == ' ' || CmdBuff[CmdPos] == '\t' || CmdBuff[CmdPos] == '\n' ) {                                              // skip all the spaces before the word
+    while (!IS_EOL(CmdBuff[CmdPos]) && IS_BLANK(CmdBuff[CmdPos])) {     // skip all the spaces before the word
         CmdPos++;
     }
 
-    while ((CmdBuff[CmdPos] != ' ' || space_flag == 1 )&& CmdBuff[CmdPos] != '\t'&&
-            CmdBuff[CmdPos] != '\n' && CmdBuff[CmdPos] != '\0')
+    while (!IS_EOL(CmdBuff[CmdPos]) && (!IS_BLANK(CmdBuff[CmdPos]) || (space_flag == 1 && CmdBuff[CmdPos] == ' ')))
         // until the next space skip everything
     {
         if (CmdBuff[CmdPos] == '\"' && skip_flag == 1) {
@@ -89,10 +102,17 @@ int Word (char* wrd) {
                 space_flag = 0;
             }
         }
-        wrd[i] = CmdBuff[CmdPos];
+        if (i < size - 1) {
+            wrd[i] = CmdBuff[CmdPos];
+        }
         i++;
         CmdPos++;
     }
+    if (i >= size) {
+        printf ("\nWord longer than %d characters ", size - 1);
+        wrd[0] = '\0';
+        return WORD_TOO_LONG;
+    }
     if (i>0) {
         count++;
     }
@@ -102,171 +122,814 @@ int Word (char* wrd) {
     return count;
 }
 
+/**
+ *
+ * \fn          ParseName(int* len)
+ * \brief       Returns the next word of the command buffer right where it is, without copying it
+ *
+ *              The word is not ended by a NUL, \a len is set to its length and is 0 at the end of the line,
+ *              where \a CmdPos is left. Blanks are told apart with \a CharClass, see IS_BLANK().
+ *
+ * \param[out]  len  length of the word
+ * \return      first character of the word in \a CmdBuff
+ *
+ */
+
+char* ParseName(int* len) {
+    char* start = &CmdBuff[CmdPos];
+    char* end;
+
+    while (!IS_EOL(*start) && IS_BLANK(*start)) {
+        start++;
+    }
+    for (end = start; !IS_BLANK(*end); end++) {        // the ends of a line are blank too
+    }
+
+    *len = end - start;
+    CmdPos = end - CmdBuff;
+    return start;
+}
+
 /**
  *
  * \fn          SkipLine(void)
  * \brief       This function skips a line from the input stream
  *
- *              This function is used for implementing line comments
+ *              This function is used for implementing line comments. The line is left as it is, it may be
+ *              part of a script mapped read only.
  *
  * \return      Nothing
  *
  */
 
 void SkipLine(void) {
-    while (CmdBuff[CmdPos] != '\n') CmdPos++;
+    while (!IS_EOL(CmdBuff[CmdPos])) CmdPos++;
 }
 
 
 /**
- * \fn          Interpret(void)
- * \brief       Compiles a word
+ * \fn          Execute(cell xt)
+ * \brief       Executes a dictionary entry
  *
- *              This function examines each word in the array and then creates an address list
- *              which corresponds to the addresses of composed code words into arr
+ *              This is the inner interpreter. \a IP always points to the next code cell. Calling a user word
+ *              pushes the return address onto the return stack and points \a IP at the code of the word,
+ *              reaching \a END_WORD pops the return address back into \a IP.
  *
+ *              The core words (those with \a Node::prim set) are executed right here in the dispatch loop and
+ *              read their inline operands at \a IP, only the remaining inbuilt words are called through
+ *              \a Node::func. With GCC the loop jumps through a table of label addresses and every primitive
+ *              dispatches the next one itself, other compilers get a dense switch. Set \a FORTH_PRIM_DISPATCH
+ *              to 0 to call \a Node::func for every word.
  *
- * \return      COMPILE_SUCCESS if the compilation was a success else COMPILE_ERROR
+ *              While the loop runs, the top of the data stack is kept in the local \a tos and \a sp points at
+ *              the slot it belongs to, so the primitives only touch memory for the second item. The stack is
+ *              written back to \a DatStack / \a DatStackTop before anything else may look at it (inbuilt
+ *              words, ticker callbacks and on return) and reloaded afterwards.
+ *
+ *              The primitives check the depth of the stack before touching it. A word whose stack use
+ *              VerifyWord() has proven is checked once when it is entered instead, its code holds the unchecked
+ *              variants of the primitives, which jump in right behind the checks.
+ *
+ *              With \a FORTH_PROFILE set, every user word nested into and every inbuilt word called is timed
+ *              by profile.c while profiling is on.
+ *
+ *              With \a FORTH_COUNT_INSNS set every dispatched word, inbuilt or not, adds one to \a InsnCount.
+ *
+ *              With \a FORTH_TOKEN_CODE set the code is read in code_units, see token.c. The token of a primitive is
+ *              dispatched on straight away, the entry of any other word is worked out from its token.
+ *
+ *              Words such as ML execute other words from within a word, so Execute has to be re-entrant. The
+ *              caller's \a IP is saved and a NULL return address marks the bottom of this invocation.
+ *
+ * \param[in]   xt  address of the dictionary entry to be executed
+ *
+ * \return      CONTINUE_FORTH_INTERPRET on success or STOP_FORTH_INTERPRET if a primitive found the data stack
+ *              empty or full or the return stack overflowed
  *
  */
 
-int Interpret(void) {
-    char Buff[SIZE];
-    static char WrdName[SIZE];
-    int ForthWrdFnd, cond, InitialAddr,TempAddr;
-    int temp, tempi;
+#define PRIM_OF(node)   (FORTH_PRIM_DISPATCH ? (node)->prim : PRIM_NONE)
+
+#if FORTH_PROFILE
+#define CALL_FUNC(node) do { if (Profiling) ProfCall(node); else (*(node)->func)(); } while (0)
+#define PROF_NEST(node) if (Profiling) ProfEnter((node), RetStackTop)
+#define PROF_UNNEST     if (ProfTop) ProfLeave(RetStackTop)
+#define PROF_UNWIND     ProfUnwind(RsBase)
+#else
+#define CALL_FUNC(node) (*(node)->func)()
+#define PROF_NEST(node)
+#define PROF_UNNEST
+#define PROF_UNWIND
+#endif
+
+#if FORTH_COUNT_INSNS
+#define COUNT_INSN      InsnCount++
+#else
+#define COUNT_INSN      ((void)0)
+#endif
+
+#if FORTH_COMPUTED_GOTO
+#define CASE(p)         L_##p:
+#define UNCHECKED(p)    U_##p:
+#define PRIM_LABEL(id, name, func, flags, in, out, checks)       &&L_PRIM_##id,
+#define UNCHECKED_LABEL(id, name, func, flags, in, out, checks)  UNCHECKED_LABEL_##checks(L_PRIM_##id, U_PRIM_##id)
+#define UNCHECKED_LABEL_0(checked, unchecked)   &&checked,  /**< No unchecked variant, the checked code runs */
+#define UNCHECKED_LABEL_1(checked, unchecked)   &&unchecked,
+#define DISPATCH(p)     goto *PrimLabels[(p)];
+#define NEXT            do { if (*IP == END_CODE) goto unnest; FETCH; COUNT_INSN; goto *PrimLabels[tok]; } while (0)
+#else
+#define CASE(p)         case p:
+#define UNCHECKED(p)    case PRIM_UNCHECKED(p):
+#define DISPATCH(p)     switch (p)
+#define NEXT            goto next
+#endif
+
+#if FORTH_TOKEN_CODE
+#define FETCH           tok = *IP++; if (tok >= TOKEN_CALL || !FORTH_PRIM_DISPATCH) { CodePtr = TOKEN_NODE(tok); tok = PRIM_OF(CodePtr); }
+#else
+#define FETCH           CodePtr = (NodePtr)*IP++; tok = PRIM_OF(CodePtr)
+#endif
+
+#define DEPTH           (sp - DatStack + 1)
+#define NEED(n)         if (DEPTH < (n)) goto underflow
+#define ROOM(n)         if (DEPTH + (n) > STACK_DAT_SIZE-1) goto overflow
+#define SPILL           do { *sp = tos; DatStackTop = DEPTH; } while (0)
+#define RELOAD          do { sp = DatStack + DatStackTop - 1; tos = *sp; } while (0)
+#define POLL            if (TickPending) { SPILL; ServiceTicker(); RELOAD; }
+
+int Execute(cell xt) {
+    code_unit *SavedIP = IP;
+    int RsBase = RetStackTop;
+    int cond;
+    cell temp;
+    cell tos, *sp;                                           // cached top of stack and the slot it belongs to
     NodePtr CodePtr;
-    func_ptr Func;
-    bool ExitFlag = FALSE;
-    int jmp = 0;
+    int tok;                                                // primitive to dispatch on
+#if FORTH_COMPUTED_GOTO
+    static void* PrimLabels[2*PRIM_COUNT] = {               // laid out like PrimNode
+        &&L_PRIM_NONE,
+        FORTH_PRIMS(PRIM_LABEL)
+        &&L_PRIM_NONE,
+        FORTH_PRIMS(UNCHECKED_LABEL)
+    };
+#endif
+
+    CodePtr = (NodePtr)xt;
+    COUNT_INSN;
+    if (CodePtr->flag & FORTH_WORD_INBUILT) {
+        CALL_FUNC(CodePtr);                                 // nothing to thread through
+        return CONTINUE_FORTH_INTERPRET;
+    }
+
+    RELOAD;
+    if (CodePtr->flag & FORTH_WORD_VERIFIED) {
+        NEED(CodePtr->StkIn);
+        ROOM(CodePtr->StkPeak);
+    }
+    PushRs(0, &cond);                                       // return address of the outermost word
+    if (cond == STACK_ERR_FULL) {
+        goto rs_full;
+    }
+    PROF_NEST(CodePtr);
+    IP = (code_unit*)CodePtr->code;
+
+#if !FORTH_COMPUTED_GOTO
+next:
+#endif
+    if (*IP == END_CODE) {
+        goto unnest;
+    }
+    FETCH;
+    COUNT_INSN;
+
+    DISPATCH(tok) {
+    CASE(PRIM_NONE)
+        if (CodePtr->flag & FORTH_WORD_INBUILT) {
+            SPILL;
+            CALL_FUNC(CodePtr);                             // execute the function
+            RELOAD;
+        } else {
+            if (CodePtr->flag & FORTH_WORD_VERIFIED) {      // the only check its primitives need
+                NEED(CodePtr->StkIn);
+                ROOM(CodePtr->StkPeak);
+            }
+            PushRs((cell)IP, &cond);                         // nest into the user word
+            if (cond == STACK_ERR_FULL) {
+                goto rs_full;
+            }
+            PROF_NEST(CodePtr);
+            IP = (code_unit*)CodePtr->code;
+        }
+        NEXT;
+
+    CASE(PRIM_LIT)
+        ROOM(1);
+    UNCHECKED(PRIM_LIT)
+        *sp++ = tos;
+        tos = CODE_CELL(IP);
+        IP += CELL_UNITS;
+        NEXT;
+
+    CASE(PRIM_BRANCH)
+        IP += CODE_OFFSET(IP);                              // offset is relative to the cell holding it
+        POLL;
+        NEXT;
+
+    CASE(PRIM_0BRANCH)
+        NEED(1);
+    UNCHECKED(PRIM_0BRANCH)
+        temp = tos;
+        tos = *--sp;
+        if (temp != 0) {
+            IP++;
+        } else {
+            IP += CODE_OFFSET(IP);
+            POLL;
+        }
+        NEXT;
+
+    CASE(PRIM_ADD)
+        NEED(2);
+    UNCHECKED(PRIM_ADD)
+        tos = *--sp + tos;
+        NEXT;
+
+    CASE(PRIM_SUB)
+        NEED(2);
+    UNCHECKED(PRIM_SUB)
+        tos = *--sp - tos;
+        NEXT;
+
+    CASE(PRIM_MUL)
+        NEED(2);
+    UNCHECKED(PRIM_MUL)
+        tos = *--sp * tos;
+        NEXT;
+
+    CASE(PRIM_DIV)
+        NEED(2);
+    UNCHECKED(PRIM_DIV)
+        if (tos == 0) {
+            sp--;                                           // leaves the 0, like Div(), / is always 2 -> 1
+            NEXT;
+        }
+        tos = *--sp / tos;
+        NEXT;
+
+    CASE(PRIM_DUP)
+        NEED(1);
+        ROOM(1);
+    UNCHECKED(PRIM_DUP)
+        *sp++ = tos;
+        NEXT;
+
+    CASE(PRIM_DROP)
+        NEED(1);
+    UNCHECKED(PRIM_DROP)
+        tos = *--sp;
+        NEXT;
+
+    CASE(PRIM_SWAP)
+        NEED(2);
+    UNCHECKED(PRIM_SWAP)
+        temp = sp[-1];
+        sp[-1] = tos;
+        tos = temp;
+        NEXT;
+
+    CASE(PRIM_OVER)
+        NEED(2);
+        ROOM(1);
+    UNCHECKED(PRIM_OVER)
+        *sp = tos;
+        tos = sp[-1];
+        sp++;
+        NEXT;
+
+    CASE(PRIM_FETCH)
+        NEED(1);
+    UNCHECKED(PRIM_FETCH)
+        tos = *(cell*)tos;
+        NEXT;
+
+    CASE(PRIM_STORE)
+        NEED(2);
+    UNCHECKED(PRIM_STORE)
+        *(cell*)tos = sp[-1];
+        sp -= 2;
+        tos = *sp;
+        NEXT;
+
+    CASE(PRIM_EQ)
+        NEED(2);
+    UNCHECKED(PRIM_EQ)
+        tos = (*--sp == tos) ? FORTH_TRUE : FORTH_FALSE;
+        NEXT;
+
+    CASE(PRIM_LT)
+        NEED(2);
+    UNCHECKED(PRIM_LT)
+        tos = (*--sp < tos) ? FORTH_TRUE : FORTH_FALSE;
+        NEXT;
+
+    CASE(PRIM_GT)
+        NEED(2);
+    UNCHECKED(PRIM_GT)
+        tos = (*--sp > tos) ? FORTH_TRUE : FORTH_FALSE;
+        NEXT;
+
+    CASE(PRIM_LTE)
+        NEED(2);
+    UNCHECKED(PRIM_LTE)
+        tos = (*--sp <= tos) ? FORTH_TRUE : FORTH_FALSE;
+        NEXT;
+
+    CASE(PRIM_GTE)
+        NEED(2);
+    UNCHECKED(PRIM_GTE)
+        tos = (*--sp >= tos) ? FORTH_TRUE : FORTH_FALSE;
+        NEXT;
+
+    CASE(PRIM_NOT)
+        NEED(1);
+    UNCHECKED(PRIM_NOT)
+        tos = tos ? FORTH_FALSE : FORTH_TRUE;
+        NEXT;
+
+    CASE(PRIM_AND)
+        NEED(2);
+    UNCHECKED(PRIM_AND)
+        tos = *--sp & tos;
+        NEXT;
+
+    CASE(PRIM_OR)
+        NEED(2);
+    UNCHECKED(PRIM_OR)
+        tos = *--sp | tos;
+        NEXT;
+
+    CASE(PRIM_XOR)
+        NEED(2);
+    UNCHECKED(PRIM_XOR)
+        tos = *--sp ^ tos;
+        NEXT;
+
+    CASE(PRIM_BITSET)
+        NEED(2);
+    UNCHECKED(PRIM_BITSET)
+        temp = *--sp;
+        tos = (((cell)1 << tos) & temp) ? FORTH_TRUE : FORTH_FALSE;
+        NEXT;
+
+    /* superinstructions, see FuseCode() */
+
+    CASE(PRIM_LIT_ADD)
+        NEED(1);
+    UNCHECKED(PRIM_LIT_ADD)
+        tos += CODE_CELL(IP);
+        IP += CELL_UNITS;
+        NEXT;
+
+    CASE(PRIM_LIT_FETCH)
+        ROOM(1);
+    UNCHECKED(PRIM_LIT_FETCH)
+        *sp++ = tos;
+        tos = *(cell*)CODE_CELL(IP);
+        IP += CELL_UNITS;
+        NEXT;
+
+    CASE(PRIM_DUP_MUL)
+        NEED(1);
+    UNCHECKED(PRIM_DUP_MUL)
+        tos = tos * tos;
+        NEXT;
+
+    CASE(PRIM_0EQ_0BRANCH)
+        NEED(1);
+    UNCHECKED(PRIM_0EQ_0BRANCH)
+        temp = tos;
+        tos = *--sp;
+        if (temp == 0) {
+            IP++;
+        } else {
+            IP += CODE_OFFSET(IP);
+            POLL;
+        }
+        NEXT;
+
+    CASE(PRIM_2DUP)
+        NEED(2);
+        ROOM(2);
+    UNCHECKED(PRIM_2DUP)
+        sp[0] = tos;
+        sp[1] = sp[-1];
+        sp += 2;
+        NEXT;
+
+    /* counted loops, the return stack holds the limit with the index above it */
+
+    CASE(PRIM_DO)
+        NEED(2);
+    UNCHECKED(PRIM_DO)
+        if (RetStackTop + 2 > STACK_RET_SIZE-1) {
+            CodePtr = PrimNode[tok];                        // for the message
+            goto rs_full;
+        }
+        RetStack[RetStackTop++] = sp[-1];
+        RetStack[RetStackTop++] = tos;
+        sp -= 2;
+        tos = *sp;
+        NEXT;
+
+    CASE(PRIM_QDO)
+        NEED(2);
+    UNCHECKED(PRIM_QDO)
+        if (sp[-1] == tos) {
+            IP += CODE_OFFSET(IP);                          // nothing to do, skip the loop
+        } else {
+            if (RetStackTop + 2 > STACK_RET_SIZE-1) {
+                CodePtr = PrimNode[tok];
+                goto rs_full;
+            }
+            RetStack[RetStackTop++] = sp[-1];
+            RetStack[RetStackTop++] = tos;
+            IP++;
+        }
+        sp -= 2;
+        tos = *sp;
+        NEXT;
+
+    CASE(PRIM_LOOP)
+    UNCHECKED(PRIM_LOOP)
+        temp = RetStack[RetStackTop-1] + 1;
+        if (temp != RetStack[RetStackTop-2]) {
+            RetStack[RetStackTop-1] = temp;
+            IP += CODE_OFFSET(IP);
+            POLL;
+        } else {
+            RetStackTop -= 2;
+            IP++;
+        }
+        NEXT;
+
+    CASE(PRIM_PLOOP)
+        NEED(1);
+    UNCHECKED(PRIM_PLOOP)
+        {
+            // done once the index crosses the boundary between limit-1 and limit, either way
+            ucell before = (ucell)RetStack[RetStackTop-1] - (ucell)RetStack[RetStackTop-2];
+            ucell after = before + (ucell)tos;
+
+            RetStack[RetStackTop-1] += tos;
+            tos = *--sp;
+            if ((cell)(before ^ after) >= 0) {
+                IP += CODE_OFFSET(IP);
+                POLL;
+            } else {
+                RetStackTop -= 2;
+                IP++;
+            }
+        }
+        NEXT;
+
+    CASE(PRIM_I)
+        ROOM(1);
+    UNCHECKED(PRIM_I)
+        *sp++ = tos;
+        tos = RetStack[RetStackTop-1];
+        NEXT;
+
+    CASE(PRIM_J)
+        ROOM(1);
+    UNCHECKED(PRIM_J)
+        *sp++ = tos;
+        tos = (RetStackTop >= 3) ? RetStack[RetStackTop-3] : 0;
+        NEXT;
+
+    CASE(PRIM_UNLOOP)
+    UNCHECKED(PRIM_UNLOOP)
+        RetStackTop -= 2;
+        NEXT;
+
+    CASE(PRIM_CASE)
+        NEED(1);
+    UNCHECKED(PRIM_CASE)
+        temp = tos - CODE_CELL(IP);                         // min span, then span offsets and the default one
+        IP += CELL_UNITS;
+        if ((ucell)temp >= (ucell)*IP) {
+            temp = *IP;
+        }
+        IP += 1 + temp;
+        IP += CODE_OFFSET(IP);
+        NEXT;
+
+    CASE(PRIM_TAIL)
+        CodePtr = CODE_XT(IP);                              // nest without pushing, the word returns to our caller
+        if (CodePtr->flag & FORTH_WORD_VERIFIED) {
+            NEED(CodePtr->StkIn);
+            ROOM(CodePtr->StkPeak);
+        }
+        PROF_UNNEST;
+        PROF_NEST(CodePtr);
+        IP = (code_unit*)CodePtr->code;
+        POLL;
+        NEXT;
+    }
 
-    i_pc = 0;
+unnest:
+    PROF_UNNEST;
+    IP = (code_unit*)PopRs(&cond);                           // return to the caller
+    if (IP != NULL) {
+        NEXT;
+    }
+    IP = SavedIP;
+    SPILL;
+    if (TickPending) {
+        ServiceTicker();
+    }
+    return CONTINUE_FORTH_INTERPRET;
 
-    if (CompileMode == FALSE) {                            // we are in interpret mode
-        Word(Buff);                                         // get a word from input stream
-        if (Buff[0] == '\0') {                              // empty string
-            return CONTINUE_FORTH_INTERPRET;
+underflow:
+    printf ("Stack under flow \n");
+    goto abort;
+
+overflow:
+    printf ("Stack full\n");
+    goto abort;
+
+rs_full:
+    printf ("Return stack full in %s \n", CodePtr->WrdName);
+
+abort:
+    SPILL;
+    PROF_UNWIND;
+    RetStackTop = RsBase;
+    IP = SavedIP;
+    return STOP_FORTH_INTERPRET;
+}
+
+
+/**
+ * \fn          ReadToken(const char* name, int len, cell* value)
+ * \brief       Tells what a word read from the input is, a word of the dictionary or a number
+ *
+ *              A word which starts with a digit and is a number in the current base is taken for a number
+ *              straight away, without looking it up. Anything else is looked up first.
+ *
+ * \param[in]   name   the word, right in the input buffer
+ * \param[in]   len    its length
+ * \param[out]  value  the dictionary entry or the number
+ *
+ * \return      LEX_WORD, LEX_NUMBER or LEX_UNKNOWN
+ */
+
+static int ReadToken(const char* name, int len, cell* value) {
+    if (DIGIT_OF(name[0]) < 10 && ParseNumber(name, len, value)) {
+        return LEX_NUMBER;
+    }
+    if (FindName(name, len, value) == FORTH_WORD_FOUND) {
+        return LEX_WORD;
+    }
+    if (ParseNumber(name, len, value)) {
+        return LEX_NUMBER;
+    }
+    return LEX_UNKNOWN;
+}
+
+
+/**
+ * \fn          CompileWord(NodePtr word, cell value, int room)
+ * \brief       Compiles a word of the input at \a j_pc of \a CompileCode, in a definition or a line
+ *
+ *              Immediate words are executed, pure words are folded over the literals before them and user words
+ *              are inlined if they fit in \a room cells, the other words are called. A number is compiled as LIT.
+ *
+ * \param[in]   word   the dictionary entry, NULL for the number \a value
+ * \param[in]   value  the number
+ * \param[in]   room   cells which may still be compiled
+ */
+
+static void CompileWord(NodePtr word, cell value, int room) {
+    int n;
+
+    if (word == NULL) {
+        CompileCode[j_pc] = (cell)PrimNode[PRIM_LIT];   // LIT reads the number stored next to it and skips it,
+        j_pc++;                                         // as in jonesforth
+        CompileCode[j_pc] = value;                      // compile the number
+        if (END_WORD == value) {
+            printf ("WARNING: Using %d in your compiled code will hang the system\n", END_WORD);
+        }
+        j_pc++;
+        return;
+    }
+
+    if (word->flag & FORTH_WORD_IMED) {
+        (*word->func)();                            // execute the function
+        LitRun = j_pc;                              // control words may branch here, nothing folds across them
+    } else if ((n = FoldCode(word, CompileCode, j_pc, LitRun)) != 0) {
+        j_pc = n;                                   // run on the literals before it, see FoldCode()
+    } else {
+        n = InlineCode(word, &CompileCode[j_pc], room);
+        if (n == 0) {
+            CompileCode[j_pc] = (cell)word;         // call it
+            n = 1;
         }
-        ForthWrdFnd = Find(Buff, &CurrentAddr);             // find the code word
+        j_pc += n;
+        if (n != 2 || CompileCode[j_pc-2] != (cell)PrimNode[PRIM_LIT]) {
+            LitRun = j_pc;                          // a constant inlined is one more literal
+        }
+    }
+}
+
+
+/**
+ *  Lines typed at the prompt or read from a file are compiled into \a LineCode as if they were the body of a
+ *  nameless definition and then run, so IF, loops and CASE work outside definitions, run at the speed of
+ *  compiled code and every word of the line is looked up once. While the line is compiled the data stack of
+ *  the user is kept in \a LineStack, the control words leave what they have to patch on the emptied stack.
+ *  A definition puts the stack aside the same way from its name to ;. A control structure still open at the
+ *  end of the line carries on into the next.
+ */
+
+static cell LineCode[FORTH_LINE_CELLS+1];   /**< Code of the line being compiled, END_WORD included */
+static struct Node LineNode;                /**< Nameless entry running \a LineCode, it is never linked into the dictionary */
+static cell LineStack[STACK_DAT_SIZE];      /**< Data stack of the user while the line is compiled */
+static int LineDepth = -1;                  /**< Cells in \a LineStack, -1 if no line is being compiled */
+
+
+/**
+ * \fn          OpenLine(void)
+ * \brief       Puts the data stack of the user aside, the control words of the line or definition get it empty
+ */
+
+static void OpenLine(void) {
+    memcpy(LineStack, DatStack, DatStackTop * sizeof(cell));
+    LineDepth = DatStackTop;
+    DatStackTop = 0;
+    j_pc = LitRun = 0;
+    StartDefinition();
+}
+
+
+/**
+ * \fn          CloseLine(void)
+ * \brief       Gives the user back the data stack, what the control words left on it is dropped
+ */
+
+static void CloseLine(void) {
+    memcpy(DatStack, LineStack, LineDepth * sizeof(cell));
+    DatStackTop = LineDepth;
+    LineDepth = -1;
+    j_pc = 0;
+    CompileMode = CompileFailed = FALSE;
+}
+
+
+/**
+ * \fn          RunLine(void)
+ * \brief       Runs the line compiled so far, through the same passes as a definition
+ *
+ * \return      CONTINUE_FORTH_INTERPRET or STOP_FORTH_INTERPRET if it failed
+ */
+
+static int RunLine(void) {
+    int len = j_pc, fused = FuseCount;
 
-        if (FORTH_WORD_NOT_FOUND == ForthWrdFnd) {
+    CloseLine();
+    if (len == 0) {
+        return CONTINUE_FORTH_INTERPRET;
+    }
+
+    len = FuseCode(LineCode, len);
+    FuseCount = fused;                          // .FUSED is about the last word defined
+    LineCode[len] = END_WORD;
+    LineNode.flag = FORTH_WORD_USER;
+    LineNode.code = LineCode;
+    LineNode.StkIn = STK_UNKNOWN;
+    LineNode.StkOut = LineNode.StkPeak = 0;
+    VerifyWord(&LineNode, len);
+    EncodeWord(&LineNode, len);
+
+    return Execute((cell)&LineNode);
+}
 
-            /* Try and parse the input as a number */
 
-            Number(Buff);
-            temp = PopDs(&cond);
-            /*if (cond == STACK_ERR_EMPTY)
-              {
+/**
+ * \fn          CompileLine(void)
+ * \brief       Compiles the rest of the input line into \a LineCode and runs it
+ *
+ *              Words marked FORTH_WORD_ALONE are not compiled: they read the line after them, change how it is
+ *              read or forget words. The line is run up to such a word, which is then executed on its own, and
+ *              the next call to Interpret() goes on with the rest of the line. They cannot be used inside an
+ *              open control structure. A line filling \a LineCode outside of one is run in parts the same way.
+ *
+ * \return      CONTINUE_FORTH_INTERPRET, CONTINUE_FORTH_COMPILE if a control structure is still open or
+ *              STOP_FORTH_INTERPRET if the line does not compile or failed
+ */
+
+static int CompileLine(void) {
+    char* name;
+    int len, kind;
+    cell value;
+    NodePtr word;
+
+    if (LineDepth < 0) {                        // a new line, put the stack of the user aside
+        OpenLine();
+    }
+    CompileCode = LineCode;
+    CompileMode = TRUE;                         // the control words turn it off when they fail
+
+    while (1) {
+        name = ParseName(&len);
+        if (len == 0) {
+            break;
+        }
+
+        kind = ReadToken(name, len, &value);
+        if (kind == LEX_UNKNOWN) {
+            printf ("%.*s not recognised \n", len, name);
+            CloseLine();
+            return STOP_FORTH_INTERPRET;
+        }
+        word = (kind == LEX_WORD) ? (NodePtr)value : NULL;
+        if (word != NULL && (word->flag & FORTH_WORD_ALONE)) {
+            if (DatStackTop > 0) {
+                printf ("%.*s cannot be used inside a control structure \n", len, name);
+                CloseLine();
+                return STOP_FORTH_INTERPRET;
+            }
+            if (RunLine() == STOP_FORTH_INTERPRET) {
                 return STOP_FORTH_INTERPRET;
-                } */
-            if ( temp != 0) {
-                printf ("%s not recognised \n", Buff);
+            }
+            return Execute(value);
+        }
 
-                temp = PopDs(&cond);                      // pop out partially converted number
+        if (j_pc + COMPILE_MARGIN > FORTH_LINE_CELLS) {
+            if (DatStackTop > 0) {
+                printf ("Line too long\n");
+                CloseLine();
                 return STOP_FORTH_INTERPRET;
             }
-        } else {
+            CmdPos = name - CmdBuff;            // run what is there, the next call goes on from this word
+            return RunLine();
+        }
+        CompileWord(word, value, FORTH_LINE_CELLS - j_pc - COMPILE_MARGIN);
+        if (CompileMode == FALSE) {
+            printf ("%.*s out of place \n", len, name);
+            CloseLine();
+            return STOP_FORTH_INTERPRET;
+        }
+    }
 
-            InitialAddr = CurrentAddr;                     // save the first ever address
-
-            CodePtr = (NodePtr)CurrentAddr;
-
-            while (1) {
-                CodePtr = (NodePtr)CurrentAddr;
-                if ((CodePtr->flag) & FORTH_WORD_INBUILT) {    // if the current code is an inbuilt function
-                    if ((CodePtr->flag) & FORTH_COMPILE_ONLY) {
-                        printf ("%s can be used only in compile mode\n", Buff);
-                        return STOP_FORTH_INTERPRET;
-                    }
-                    Func = CodePtr->func;
-                    (*Func)();                              // execute the function
-
-                    if (CompileMode == TRUE) {
-                        break;
-                    }
-
-                    CurrentAddr = PopRs(&cond);            // pop up for next execution
-                    i_pc = PopRs(&cond);
-
-                    CodePtr = (NodePtr)InitialAddr;
-
-                    if (CurrentAddr == InitialAddr) {      // this becomes true if we are nearing bottom of the stack
-                        PushRs(i_pc, &cond);           // make a copy before subsequent pops
-                        PushRs(InitialAddr, &cond);
-                        CodePtr = (NodePtr)InitialAddr;
-                        if (CodePtr->code[i_pc] == END_WORD) { // is it end of the word
-                            CurrentAddr = PopRs(&cond);
-                            CurrentAddr = PopRs(&cond);  // we do not want to leave some thing stack
-                            ExitFlag = TRUE;       // then exit. Remember we are the initial address, first code
-                        } else {
-                            CurrentAddr = PopRs(&cond);  // if the word is not finished yet, pop up the recent address
-                            i_pc = PopRs(&cond);
-                        }
-                    }
-
-                    jmp = 0;                               // jmp pointer helps us reset i_pc when we jump to a another word
-                    // from where we are
-                    if (cond == STACK_ERR_EMPTY) {
-                        ExitFlag = TRUE;               // Exit if stack is empty
-                    }
-                } else {
-
-                    jmp++;                      // if we are here more than twice we did not execute any inbuilt function
-                    // which can mean only one thing, we are executing non-inbuilt function
-
-                    if (jmp > 1) {
-                        i_pc =0;                      // therefore reset pointer so that the new word can begin executing from
-                    }                               // code[0] of new word
-
-                    if (CodePtr->code[0] == EMPTY_WORD) {
-                        temp = PopRs(&cond);
-                        tempi = PopRs(&cond);
-                        if (temp == STACK_ERR_EMPTY) {
-                            return CONTINUE_FORTH_INTERPRET;
-                        }
-                        PushRs(tempi, &cond);
-                        PushRs(temp, &cond);
-                        i_pc++;
-
-
-                    }
-                    if (CodePtr->code[i_pc+1] != END_WORD) {     // do not save address if we are nearing delem
-                        PushRs(i_pc+1, &cond);
-                        PushRs(CurrentAddr, &cond);
-                    }
-
-                    CurrentAddr = CodePtr->code[i_pc];
-                    CodePtr = (NodePtr)CurrentAddr;
-                    i_pc++;                               // increment program counter
-                }
-
-                if (CurrentAddr == END_WORD) {
-                    CurrentAddr = PopRs(&cond);          // if at end of a word pop up the addresses
-                    i_pc = PopRs(&cond);
-
-                    CurrentAddr = PopRs(&cond);
-                    i_pc = PopRs(&cond);
-
-
-                    CodePtr = (NodePtr)InitialAddr;     // see if we have reached the end of original code
-                    if (CodePtr->code[i_pc] != END_WORD) {
-                        PushRs(i_pc, &cond);        // if not push the address for next cycle
-                        PushRs(InitialAddr, &cond);
-                    }
-
-                    if (CurrentAddr == 0 || cond == STACK_ERR_EMPTY) {
-                        ExitFlag = TRUE;            // exit
-                        break;
-                    }
-
-                    CodePtr = (NodePtr)CurrentAddr;   // if we have come till here there are still some word to be executed
-                    CurrentAddr = CodePtr->code[i_pc];
-                }
-                if (TRUE == ExitFlag) {
-                    break;
-                }
+    CompileMode = FALSE;
+    if (DatStackTop > 0) {
+        return CONTINUE_FORTH_COMPILE;          // run once the control structure is closed
+    }
+    return RunLine();
+}
 
-            }
+
+/**
+ * \fn          AbortDefinition(void)
+ * \brief       Drops the word being defined, it is never linked, and the rest of the line it failed on
+ *
+ * \return      COMPILE_ERROR
+ */
+
+static int AbortDefinition(void) {
+    AbortDicEntry();
+    CloseLine();
+    WrdNameFlag = FALSE;
+    SkipLine();
+    return COMPILE_ERROR;
+}
+
+
+/**
+ * \fn          Interpret(void)
+ * \brief       Compiles a word
+ *
+ *              This function examines each word in the array and then creates an address list
+ *              which corresponds to the addresses of composed code words into arr
+ *
+ *              Outside a definition the line is compiled and run by CompileLine().
+ *
+ * \return      COMPILE_SUCCESS if the compilation was a success else COMPILE_ERROR
+ *
+ */
+
+int Interpret(void) {
+    char Buff[SIZE];
+    static char WrdName[SIZE];
+    char* name;
+    int len, kind, res;
+    cell TempAddr, temp;
+    NodePtr CodePtr;
+
+    if (CompileMode == FALSE) {                            // we are in interpret mode
+        res = CompileLine();
+        if (CompileMode == FALSE || res == STOP_FORTH_INTERPRET) {
+            return res;
         }
     }
 
@@ -276,72 +939,69 @@ int Interpret(void) {
         // of array to enter into the dictionary entry but first we need to know the name of the word
 
         if (WrdNameFlag == FALSE) {
-            Word(Buff);                          // take in the next word
+            if (Word(Buff, sizeof(Buff)) == WORD_TOO_LONG) {  // take in the next word
+                CompileMode = FALSE;
+                SkipLine();
+                return COMPILE_ERROR;
+            }
             // this one should be name
             if (Buff[0] == '\0') {
                 CompileMode = FALSE;
                 return CONTINUE_FORTH_INTERPRET ;
             }
             strcpy(WrdName, Buff);
+            CompileCode = StartDicEntry(WrdName, FORTH_WORD_USER);
+            if (CompileCode == NULL) {
+                printf ("Dictionary full\n");
+                CompileMode = FALSE;
+                return COMPILE_ERROR;
+            }
+            OpenLine();
             WrdNameFlag = TRUE;
         }
         //j_pc = 0;                               // set counter = 0
         while (1) {
-            Word(Buff);
+            name = ParseName(&len);
 
-            if (Buff[0] == '\0') {
+            if (len == 0) {
                 return CONTINUE_FORTH_COMPILE ;
             }
 
-            //if( strcmp(Buff, ";") == 0) break;
-            ForthWrdFnd = Find(Buff, &TempAddr);
-            if (FORTH_WORD_FOUND == ForthWrdFnd) {
-                CodePtr = (NodePtr)TempAddr;
-                if ((CodePtr->flag) & (FORTH_WORD_IMED)) {
-                    Func = CodePtr->func;
-                    (*Func)();                              // execute the function
-
-                    if (CompileMode == FALSE) {
-                        break;
-                    }
-                } else {
-                    CompileCode[j_pc] = TempAddr;
-                    j_pc++;
-                }
-            } else {
-                // try parsing it as a number
-                Number(Buff);
-                temp = PopDs(&cond);
-
-                if (temp == 0) {    // it is number
-                    Find("LIT", &TempAddr);         // First we add an address of word LIT
-                    CompileCode[j_pc] = TempAddr;   // what it does is reads the number (stored next in word i.e in CodeArr as you
-                    j_pc++;                      // will see in next line) and then skips this location as if never occured as in jonesforth
-                    temp = CompileCode[j_pc] = PopDs(&cond);  // compile the number
-                    if (END_WORD == temp) {
-                        printf ("WARNING: Using %d in your compiled code will hang the system\n", END_WORD);
-                    }
-                    j_pc++;
-                } else {
-                    temp = PopDs(&cond);      // word not found
-                    printf ("Word %s not found \n", Buff);
-                    j_pc = 0;
-                    WrdNameFlag = CompileMode = FALSE;  // continue interpreting
-                    return COMPILE_ERROR;
-                }
+            if (DicRoom() < (int)sizeof(struct Node) + (j_pc + COMPILE_MARGIN) * (int)sizeof(cell)) {
+                printf ("Dictionary full\n");
+                return AbortDefinition();
+            }
+
+            kind = ReadToken(name, len, &TempAddr);
+            if (kind == LEX_UNKNOWN) {
+                printf ("Word %.*s not found \n", len, name);
+                return AbortDefinition();       // continue interpreting
+            }
+            CodePtr = (kind == LEX_WORD) ? (NodePtr)TempAddr : NULL;
+            if (CodePtr != NULL && (CodePtr->flag & FORTH_WORD_ALONE)) {
+                PendingEntry()->flag |= FORTH_WORD_ALONE;   // so is a word using it
+            }
+            CompileWord(CodePtr, TempAddr, (DicRoom() - (int)sizeof(struct Node)) / (int)sizeof(cell) - j_pc - COMPILE_MARGIN);
+            if (CompileFailed == TRUE) {
+                printf ("%.*s out of place \n", len, name);
+                return AbortDefinition();
+            }
+            if (CompileMode == FALSE) {             // ;
+                break;
             }
-        }
-        if (j_pc == 0) {
-            CompileCode[j_pc] = EMPTY_WORD;
-            j_pc++;
         }
         temp = Find(WrdName, &TempAddr);
         if ( FORTH_WORD_FOUND == temp) {
             printf ("\nWARNING: %s redefined ", WrdName);
         }
-        AddDicEntry(WrdName, FORTH_WORD_USER, NULL, CompileCode, j_pc);
-        j_pc = 0;
-        WrdNameFlag = CompileMode = FALSE;
+        if (EndDicEntry(j_pc) != NODE_ADDING_SUCCESS) {
+            printf ("Dictionary full\n");
+        } else {
+            VerifyWord(LATEST, j_pc);
+            EncodeWord(LATEST, j_pc);
+        }
+        CloseLine();
+        WrdNameFlag = FALSE;
 
 
     }
@@ -351,95 +1011,46 @@ int Interpret(void) {
 
 /**
  *
- * \fn           power (int base, int pwr)
- *
- * \brief        computes the power of number raised to a given number
- *
- * \param[in]   base  The base number to which power has to be raised
- * \param[in]   pwr   The power that will be raised on to the base
- *
- * \return       base^pwr
+ *   \fn           ParseNumber(const char* str, int len, cell* value)
+ *   \brief        Converts a word of \a len characters to a number, in one pass from left to right
  *
+ *                 The number is read in the base held in \a BASE unless it starts with $ (hex), % (binary) or #
+ *                 (decimal). A - may follow the prefix. Digits above 9 are letters, in upper or lower case.
  *
+ *   \param[in]    str    the word, not necessarily ended by a NUL
+ *   \param[in]    len    its length
+ *   \param[out]   value  the number, set only if the whole word is one
+ *   \return       1 if the word is a number, 0 otherwise
  */
 
-int power(int base, int pwr) {
-    int i;
-    int temp=1;
-
-    if (pwr == 0) {
-        return 1;
-    }
-
-    for (i=0; i<pwr; i++)
-        temp = temp*base;
+int ParseNumber(const char* str, int len, cell* value) {
+    const char* end = str + len;
+    int base = BASE, neg = 0, digit;
+    ucell result = 0;
 
-    return temp;
-}
-
-/**
- *
- *   \fn           Number(char* str)
- *   \brief        This function converts a string to number.
- *                 This function converts a string to number in current base system and leaves it on the data stack.
- *                 After this function has finished executing the tos would have 0 if the number was parsed successfully
- *                 else it leaves number of unparsed numbers. NOS contains the result.
- *   \param[in]    str  contains the string to be converted into numerals
- *   \note         Forth has this feature where in variable base can be used so this function
- *                 implements variable base system.
- *                 Uses variable \a BASE for using a particular base system.
-*
-*/
-
-void Number(char* str) {
-    int i=0, j=0, temp, negflag = 0;
-    int cond;
-    int result = 0;
-    i = strlen(str);
-
-    i--;
-
-    while (i >= 0) {
-        if (str[i] >= '0' && str[i] <= '9') {
-            temp = str[i] - '0';
-
-        } else if (str[i] >= 'A' && str[i] <= 'Z') {
-            temp = str[i] - 'A';
-            temp = temp + 10;
-        } else if (str[i]  == '-') {
-            negflag = 1;
-            i--;                       // subtract i for '-' at str[i]
-            break;
-        } else {
-            break;
-        }
-
-
-        if (temp < BASE) {            // check if this is an allowed number in current base system
-            result = result + temp * power(BASE, j);
-            j++;
-            i--;
-        } else {
-            break;
+    if (str < end) {
+        switch (*str) {
+        case '$': base = 16; str++; break;
+        case '%': base = 2;  str++; break;
+        case '#': base = 10; str++; break;
         }
     }
-
-    if (negflag == 1) {         // number is negative
-        result = result*(-1);
+    if (str < end && *str == '-') {
+        neg = 1;
+        str++;
     }
-    i++;                        // while will decrement it one extra time
-    PushDs(result, &cond);
-    PushDs(i , &cond);          // i will contain characters that were not parsed correctly, 0 if all is well
-
-
-    if (cond == STACK_ERR_FULL) { // no point in storing either number or result
-        printf (HoldBuffer, "\nStack is Full ");
-        PopDs(&cond);         // do not leave any left overs
+    if (str == end) {
+        return 0;                   // no digits
     }
-}
-
-
-
-
 
+    for ( ; str < end; str++) {
+        digit = DIGIT_OF(*str);     // CHAR_NODIGIT is above every base
+        if (digit >= base) {
+            return 0;
+        }
+        result = result * base + digit;
+    }
 
+    *value = neg ? -(cell)result : (cell)result;
+    return 1;
+}
@@ -30,27 +30,70 @@
 #ifndef __INTERPRETER_H
 #define __INTERPRETER_H
 
-#define BUFFER_SIZE      100         /**< Buffer size for holding commands to be parsed */
+#include "types.h"
+#include "CoreForth.h"
 
-#define RESET_CMDPOS    CmdPos = 0  /**< Reset command pos so that it points to the begining of the CmdBuff */
+#define BUFFER_SIZE      100         /**< Buffer size for holding commands typed in, scripts have longer lines */
 
-#define EMPTY_WORD       7          /**< Inserted when there is empty word defination */
+#define RESET_CMDPOS    CmdPos = 0  /**< Reset command pos so that it points to the begining of the CmdBuff */
+#define IS_EOL(c)       ((c) == '\0' || (c) == '\n')    /**< A line ends at a NUL or, read in place from a script, a newline */
 
 #define COMPILE_SUCCESS  0          /**< Error code to indicate compilation was successfull */
 #define COMPILE_ERROR    1          /**< Error code to indicate compilation was unsuccesfull */
 #define STOP_FORTH_INTERPRET 3      /**< Indication to stop interpreting */
 #define CONTINUE_FORTH_INTERPRET 4  /**< continue interpreting */
 #define CONTINUE_FORTH_COMPILE   5  /**< continue compiling */
-#define FORTH_CODE_SIZE      100              /**< Maximum words a dictionary entry can have */
+#define WORD_TOO_LONG   (-1)        /**< Word() was given a word longer than its buffer */
+#define LEX_UNKNOWN      0          /**< A word read from the input is neither in the dictionary nor a number */
+#define LEX_WORD         1          /**< It is in the dictionary */
+#define LEX_NUMBER       2          /**< It is a number */
+#define FORTH_CODE_SIZE      100              /**< Longest word the optimiser works on, longer ones are left as they are */
+#define COMPILE_MARGIN        32              /**< Cells kept free while compiling, enough for a string filling a line */
+
+#ifndef FORTH_LINE_CELLS
+#define FORTH_LINE_CELLS     128              /**< Cells of code a line compiled outside a definition may take, see CompileLine() */
+#endif
 
+#ifndef FORTH_INLINE_CELLS
+#define FORTH_INLINE_CELLS     8              /**< User words with up to this many cells of code are inlined, 0 turns it off */
+#endif
+
+#ifndef FORTH_FOLD_DEBUG
+#define FORTH_FOLD_DEBUG       0              /**< 1 reports every constant the compiler folds and every IF arm it drops */
+#endif
 
+#ifndef FORTH_PRIM_DISPATCH
+#define FORTH_PRIM_DISPATCH  1      /**< 1 executes the core words inside Execute(), 0 calls Node::func for every word */
+#endif
 
-extern char CmdBuff[BUFFER_SIZE];
+#ifndef FORTH_COUNT_INSNS
+#define FORTH_COUNT_INSNS    0      /**< 1 counts every word Execute() dispatches in \a InsnCount, for the benchmarks */
+#endif
+
+#if defined(__GNUC__) && !defined(FORTH_USE_SWITCH)
+#define FORTH_COMPUTED_GOTO  1      /**< Dispatch the primitives through a table of label addresses */
+#else
+#define FORTH_COMPUTED_GOTO  0      /**< Dispatch the primitives through a switch */
+#endif
+
+
+
+extern char TermBuff[BUFFER_SIZE];
+extern char* CmdBuff;
+extern int LineComment;
+extern code_unit *IP;
+#if FORTH_COUNT_INSNS
+extern unsigned long InsnCount;
+#endif
 
-int Word (char* wrd);
+int Word (char* wrd, int size);
+void SkipLine(void);
 int Interpret(void);
-void Number(char* str);
-int Find(char* name, int* addr);
+int Execute(cell xt);
+char* ParseName(int* len);
+int ParseNumber(const char* str, int len, cell* value);
+int Find(char* name, cell* addr);
+int FindName(const char* name, int len, cell* addr);
 
 
 #endif
@@ -0,0 +1,519 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       optimise.c
+ * \brief      Peephole passes over compiled code
+ *
+ *             The passes run from StopCompile() over \a CompileCode before the word is entered into the dictionary.
+ *             Every pass has to walk the code the way the inner interpreter does: a cell is either a word or an
+ *             inline operand of the word before it (the number after LIT, the offset after a branch, the packed
+ *             characters after STR, the jump table after (CASE)). Branch offsets are relative to the cell holding
+ *             the offset.
+ *
+ *             VerifyWord() runs on the finished entry and may swap the primitives for their unchecked variants,
+ *             PrimAt() sees through them. InlineCode() runs while compiling, for every user word called.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "CoreForth.h"
+#include "interprter.h"
+#include "optimise.h"
+#include "stack.h"
+#include "token.h"
+
+int FuseCount;                              /**< Number of superinstructions in the last compiled word */
+
+static int IsTarget[FORTH_CODE_SIZE+1];     /**< Non zero if a branch lands on the cell */
+static int NewPos[FORTH_CODE_SIZE+1];       /**< Where each cell ended up after fusion */
+static int BranchAt[FORTH_CODE_SIZE];       /**< New index of every branch offset cell */
+static int BranchTo[FORTH_CODE_SIZE];       /**< Old index of the cell the branch lands on */
+static int Depth[FORTH_CODE_SIZE+1];        /**< Stack depth at each cell relative to the entry, DEPTH_UNSEEN */
+static int Work[FORTH_CODE_SIZE+1];         /**< Cells still to be followed by VerifyWord() */
+
+#define DEPTH_UNSEEN        0x7fff          /**< Depth of a cell not reached yet */
+#define DEPTH_OPERAND       0x7ffe          /**< Depth of an operand cell, no branch may land there */
+
+
+/**
+ *
+ * \fn          PrimAt(cell* code, int i)
+ * \brief       Returns the primitive compiled at a cell, PRIM_NONE for other words
+ *
+ */
+
+static int PrimAt(cell* code, int i) {
+    return PRIM_BASE(((NodePtr)code[i])->prim);
+}
+
+
+/**
+ *
+ * \fn          IsBranch(int prim)
+ * \brief       Tells if a primitive is followed by a branch offset
+ *
+ */
+
+static int IsBranch(int prim) {
+    return prim == PRIM_BRANCH || prim == PRIM_0BRANCH || prim == PRIM_0EQ_0BRANCH ||
+           prim == PRIM_QDO || prim == PRIM_LOOP || prim == PRIM_PLOOP;
+}
+
+
+/**
+ *
+ * \fn          OperandCells(cell* code, int i, int len)
+ * \brief       Returns the number of inline operand cells following the word at \a i
+ *
+ * \param[in]   code  compiled code
+ * \param[in]   i     index of a word in \a code
+ * \param[in]   len   number of cells in \a code, a string operand is not followed past it
+ *
+ */
+
+int OperandCells(cell* code, int i, int len) {
+    static NodePtr StrNode;
+    int n, b, prim;
+    ucell packed;
+
+    prim = PrimAt(code, i);
+    if (prim == PRIM_LIT || prim == PRIM_LIT_ADD || prim == PRIM_LIT_FETCH || prim == PRIM_TAIL || IsBranch(prim)) {
+        return 1;
+    }
+    if (prim == PRIM_CASE) {
+        n = i+2 < len ? 3 + (int)code[i+2] : 0;             // min, span, the offsets and the default
+        return (n < 0 || i+n >= len) ? len-i-1 : n;
+    }
+
+    if (StrNode == NULL) {
+        Find("STR", (cell*)&StrNode);
+    }
+
+    if ((NodePtr)code[i] == StrNode) {
+        // string is over at the first cell holding a 0 byte
+        for (n=1; i+n < len; n++) {
+            packed = code[i+n];
+            for (b=0; b<(int)sizeof(cell); b++, packed >>= 8) {
+                if (!(packed & 0xff)) {
+                    return n;
+                }
+            }
+        }
+        return len-i-1;
+    }
+
+    return 0;
+}
+
+
+/**
+ *
+ * \fn          BranchCells(cell* code, int i, int len, int* first)
+ * \brief       Returns the number of branch offsets following the word at \a i and sets \a first to the first one
+ *
+ *              A branch has one offset, the jump table of (CASE) has one for every value it covers and one for
+ *              the default.
+ *
+ */
+
+static int BranchCells(cell* code, int i, int len, int* first) {
+    int prim = PrimAt(code, i);
+
+    *first = i+1;
+    if (prim == PRIM_CASE) {
+        *first = i+3;
+        return OperandCells(code, i, len) - 2;
+    }
+    return (IsBranch(prim) && i+1 < len) ? 1 : 0;
+}
+
+
+/**
+ *
+ * \fn          IsTailCall(cell* code, int i, int len)
+ * \brief       Tells if the word at \a i is a call to a user word after which the word being compiled returns
+ *
+ *              That is when the call is the last word, or is followed by a BRANCH, or a chain of them, to the end.
+ *
+ */
+
+static int IsTailCall(cell* code, int i, int len) {
+    int n, hops;
+
+    if (PrimAt(code, i) != PRIM_NONE || (((NodePtr)code[i])->flag & FORTH_WORD_INBUILT)) {
+        return 0;
+    }
+    if (i+1 == len) {
+        return 1;
+    }
+    if (IsTarget[i+1] || IsTarget[i+2]) {
+        return 0;
+    }
+    for (n=i+1, hops=0; n>=0 && n+1<len && hops<len && PrimAt(code, n) == PRIM_BRANCH; hops++) {
+        n += 1 + code[n+1];
+    }
+    return n == len && hops > 0;
+}
+
+
+/**
+ *
+ * \fn          FuseCode(cell* code, int len)
+ * \brief       Replaces common sequences of words with superinstructions
+ *
+ *              The following sequences are fused, each saving one or more trips through the dispatch loop:
+ *
+ *              LIT n +            ->  (LIT+) n
+ *              LIT addr @         ->  (LIT@) addr
+ *              DUP *              ->  (DUP*)
+ *              LIT 0 = 0BRANCH o  ->  (0=0BRANCH) o
+ *              OVER OVER          ->  (2DUP)
+ *              word               ->  (TAIL) word      a user word called last
+ *              word BRANCH o      ->  (TAIL) word      the same when the branch goes to the end
+ *
+ *              A sequence is left alone if a branch lands anywhere but on its first word. The code is rewritten
+ *              in place and the offsets of all branches are recomputed afterwards. A tail call at the very end
+ *              grows the code by a cell, the compiler keeps \a COMPILE_MARGIN cells free past it. \a FuseCount is
+ *              set to the number of fusions made. Words longer than \a FORTH_CODE_SIZE cells are left as they are.
+ *
+ * \param[in,out] code  compiled code of the word
+ * \param[in]     len   number of cells in \a code
+ *
+ * \return      New number of cells in \a code
+ *
+ */
+
+int FuseCode(cell* code, int len) {
+    int i, j, n, b, at, prim, branches;
+    cell lit;
+
+    FuseCount = 0;
+    if (!FORTH_PRIM_DISPATCH || len > FORTH_CODE_SIZE) {
+        return len;
+    }
+
+    memset(IsTarget, 0, sizeof(IsTarget));
+    for (i=0; i<len; i += 1 + OperandCells(code, i, len)) {
+        for (b=BranchCells(code, i, len, &at); b>0; b--, at++) {
+            n = at + code[at];
+            if (n >= 0 && n <= len) {
+                IsTarget[n] = 1;
+            }
+        }
+    }
+
+    i = j = branches = 0;
+    while (i < len) {
+        prim = PrimAt(code, i);
+        NewPos[i] = j;
+
+        if (IsTailCall(code, i, len)) {
+            lit = code[i];
+            n = (i+1 == len) ? 1 : 3;
+            for (; n > 0; n--, i++) {
+                NewPos[i] = j;
+            }
+            code[j++] = (cell)PrimNode[PRIM_TAIL];
+            code[j++] = lit;
+            FuseCount++;
+        } else if (prim == PRIM_LIT && i+2 < len && !IsTarget[i+2] &&
+                (PrimAt(code, i+2) == PRIM_ADD || PrimAt(code, i+2) == PRIM_FETCH)) {
+            lit = code[i+1];
+            NewPos[i+1] = NewPos[i+2] = j;
+            code[j++] = (cell)PrimNode[PrimAt(code, i+2) == PRIM_ADD ? PRIM_LIT_ADD : PRIM_LIT_FETCH];
+            code[j++] = lit;
+            i += 3;
+            FuseCount++;
+        } else if (prim == PRIM_LIT && i+4 < len && code[i+1] == 0 && !IsTarget[i+2] && !IsTarget[i+3] &&
+                   PrimAt(code, i+2) == PRIM_EQ && PrimAt(code, i+3) == PRIM_0BRANCH) {
+            BranchAt[branches] = j+1;
+            BranchTo[branches++] = i+4 + code[i+4];
+            NewPos[i+1] = NewPos[i+2] = NewPos[i+3] = NewPos[i+4] = j;
+            code[j++] = (cell)PrimNode[PRIM_0EQ_0BRANCH];
+            code[j++] = 0;                                  // fixed up below
+            i += 5;
+            FuseCount++;
+        } else if (i+1 < len && !IsTarget[i+1] && ((prim == PRIM_DUP && PrimAt(code, i+1) == PRIM_MUL) ||
+                                                    (prim == PRIM_OVER && PrimAt(code, i+1) == PRIM_OVER))) {
+            NewPos[i+1] = j;
+            code[j++] = (cell)PrimNode[prim == PRIM_DUP ? PRIM_DUP_MUL : PRIM_2DUP];
+            i += 2;
+            FuseCount++;
+        } else {
+            n = OperandCells(code, i, len);
+            for (b=BranchCells(code, i, len, &at); b>0; b--, at++) {
+                BranchAt[branches] = j + at-i;
+                BranchTo[branches++] = at + code[at];
+            }
+            for (n += i+1; i < n; i++) {
+                NewPos[i] = j;
+                code[j++] = code[i];
+            }
+        }
+    }
+    NewPos[len] = j;
+
+    for (n=0; n<branches; n++) {
+        i = BranchTo[n];
+        if (i >= 0 && i <= len) {
+            code[BranchAt[n]] = NewPos[i] - BranchAt[n];
+        }
+    }
+
+    return j;
+}
+
+
+/**
+ *
+ * \fn          VerifyWord(NodePtr node, int len)
+ * \brief       Infers the stack effect of a user word and drops the stack checks of its primitives
+ *
+ *              Every path through the code is followed with the depth of the data stack relative to the entry of
+ *              the word, using the stack effects of the words it calls. The effect is known when every word
+ *              called has a known effect and every path reaching a cell arrives with the same depth, which
+ *              means that loops have to leave the stack as they found it.
+ *
+ *              The word then takes \a StkIn cells, leaves \a StkOut and never has more than \a StkPeak above the
+ *              depth it was called at. Execute() checks the depth once when it nests into a verified word, so
+ *              the primitives in it are switched to their unchecked variants and the word is flagged
+ *              \a FORTH_WORD_VERIFIED. Words which cannot be analysed are left alone and keep their checks.
+ *
+ * \param[in]   node  the entry, code included
+ * \param[in]   len   number of cells in its code, END_WORD not counted
+ *
+ * \return      1 if the word was verified, 0 otherwise
+ *
+ */
+
+int VerifyWord(NodePtr node, int len) {
+    cell* code = node->code;
+    int i, j, n, b, at, d, top, lo, hi, out, prim;
+    NodePtr word;
+
+    if (!FORTH_PRIM_DISPATCH || len > FORTH_CODE_SIZE) {
+        return 0;
+    }
+
+    for (i=0; i<=len; i++) {
+        Depth[i] = DEPTH_OPERAND;
+    }
+    for (i=0; i<len; i += 1 + OperandCells(code, i, len)) {
+        Depth[i] = DEPTH_UNSEEN;                            // a branch left unresolved lands on its own offset
+    }
+    Depth[len] = DEPTH_UNSEEN;
+    Depth[0] = lo = hi = top = 0;
+    Work[top++] = 0;
+    out = DEPTH_UNSEEN;
+
+    while (top > 0) {
+        i = Work[--top];
+        d = Depth[i];
+        if (i == len) {                                     // falls off the end
+            if (out != DEPTH_UNSEEN && out != d) {
+                return 0;
+            }
+            out = d;
+            continue;
+        }
+
+        word = (NodePtr)code[i];
+        if (PrimAt(code, i) == PRIM_TAIL && i+1 < len) {
+            word = (NodePtr)code[i+1];                      // has the effect of the word it calls
+        }
+        if (word->StkIn == STK_UNKNOWN) {
+            return 0;
+        }
+        if (d - word->StkIn < lo) {
+            lo = d - word->StkIn;
+        }
+        if (d + word->StkPeak > hi) {
+            hi = d + word->StkPeak;
+        }
+        if (-lo > STACK_DAT_SIZE || hi > STACK_DAT_SIZE) {
+            return 0;
+        }
+        d += word->StkOut - word->StkIn;
+
+        // successors: the next word, and the targets of a branch
+        prim = PrimAt(code, i);
+        b = BranchCells(code, i, len, &at);
+        for (j=-1; j<b; j++) {
+            if (j >= 0) {
+                n = at+j + code[at+j];
+            } else if (prim == PRIM_BRANCH || prim == PRIM_CASE) {
+                continue;
+            } else if (prim == PRIM_TAIL) {
+                n = len;                                    // returns from the word
+            } else {
+                n = i+1 + OperandCells(code, i, len);
+            }
+            if (n < 0 || n > len) {
+                return 0;
+            }
+            if (Depth[n] == DEPTH_UNSEEN) {
+                Depth[n] = d;
+                Work[top++] = n;
+            } else if (Depth[n] != d) {
+                return 0;
+            }
+        }
+    }
+    if (out == DEPTH_UNSEEN) {
+        return 0;                                           // never returns
+    }
+
+    node->StkIn = -lo;
+    node->StkOut = out - lo;
+    node->StkPeak = hi;
+    node->flag |= FORTH_WORD_VERIFIED;
+
+    for (i=0; i<len; i += 1 + OperandCells(code, i, len)) {
+        prim = ((NodePtr)code[i])->prim;
+        if (Depth[i] != DEPTH_UNSEEN && prim != PRIM_NONE && prim < PRIM_COUNT && PrimNode[PRIM_UNCHECKED(prim)]) {
+            code[i] = (cell)PrimNode[PRIM_UNCHECKED(prim)];
+        }
+    }
+
+    return 1;
+}
+
+
+/**
+ *
+ * \fn          InlineCode(NodePtr word, cell* dest, int room)
+ * \brief       Copies the code of a user word to where a call to it would be compiled
+ *
+ *              Words with up to \a FORTH_INLINE_CELLS cells of code are inlined, and words marked INLINE whatever
+ *              their size. Words marked NOINLINE, immediate words, words calling themselves and words ending in a
+ *              tail call, which would return from the word they are copied into, are not. The
+ *              branch offsets are relative and a branch to the end of the word lands just past the copy, so the
+ *              code is copied as it is, only unchecked primitives are put back to the checked ones: the word
+ *              compiled may not be verified. Nothing has to be undone if the word inlined is redefined or
+ *              forgotten, its callers go with it. Token code is unpacked with DecodeWord() first.
+ *
+ * \param[in]   word  the word called
+ * \param[out]  dest  where the call would be compiled
+ * \param[in]   room  most cells which may be written to \a dest
+ *
+ * \return      Number of cells copied, 0 if the word has to be called
+ *
+ */
+
+int InlineCode(NodePtr word, cell* dest, int room) {
+    cell* code = word->code;
+    int i, len, prim;
+
+    if (!(word->flag & FORTH_WORD_USER) || code == NULL || (word->flag & (FORTH_WORD_IMED | FORTH_WORD_NOINLINE))) {
+        return 0;
+    }
+    if (!(word->flag & FORTH_WORD_INLINE) && room > FORTH_INLINE_CELLS) {
+        room = FORTH_INLINE_CELLS;
+    }
+#if FORTH_TOKEN_CODE
+    if (DecodeWord(word, dest, room) == 0) {    // unpacked right where it goes
+        return 0;
+    }
+    code = dest;
+#endif
+
+    for (len=0; code[len] != END_WORD; len += 1 + OperandCells(code, len, room+1)) {
+        if (len >= room || (NodePtr)code[len] == word || PrimAt(code, len) == PRIM_TAIL) {
+            return 0;
+        }
+    }
+    if (len == 0 || len > room) {
+        return 0;
+    }
+
+    if (code != dest) {
+        memcpy(dest, code, len * sizeof(cell));
+    }
+    for (i=0; i<len; i += 1 + OperandCells(code, i, len)) {
+        prim = ((NodePtr)code[i])->prim;
+        if (prim >= PRIM_COUNT) {
+            dest[i] = (cell)PrimNode[PRIM_BASE(prim)];
+        }
+    }
+
+    return len;
+}
+
+
+/**
+ *
+ * \fn          FoldCode(NodePtr word, cell* code, int at, int from)
+ * \brief       Folds a pure inbuilt word over the literals compiled just before it
+ *
+ *              code[from] .. code[at-1] are LIT n pairs and nothing branches between them. If \a word is marked
+ *              FORTH_WORD_PURE and takes no more cells than there are literals, it is run now on the last of them
+ *              and a single LIT of its result replaces them, so 1000 4 * compiles to LIT 4000 and 2 16 ?BITSET
+ *              to LIT 0. A division by a literal 0 is left in the code for the run time to deal with.
+ *
+ * \param[in]   word  the word about to be compiled
+ * \param[in]   code  code of the word being compiled
+ * \param[in]   at    where \a word would be compiled
+ * \param[in]   from  first cell of the literals
+ *
+ * \return      Where compiling goes on from, 0 if \a word has to be compiled as usual
+ *
+ */
+
+int FoldCode(NodePtr word, cell* code, int at, int from) {
+    int in, i, cond;
+    cell result;
+
+    if (!(word->flag & FORTH_WORD_PURE) || word->StkOut != 1) {
+        return 0;
+    }
+    in = word->StkIn;
+    if (in < 1 || 2*in > at - from || (word->prim == PRIM_DIV && code[at-1] == 0)) {
+        return 0;
+    }
+
+    for (i=in; i>0; i--) {                      // the data stack holds the control words' bookkeeping, pushed over
+        if (PushDs(code[at - 2*i + 1], &cond) != STACK_ERR_SUCCESS) {
+            while (++i <= in) {
+                PopDs(&cond);
+            }
+            return 0;
+        }
+    }
+    (*word->func)();
+    result = PopDs(&cond);
+
+#if FORTH_FOLD_DEBUG
+    printf ("\nFolded");
+    for (i=in; i>0; i--) {
+        printf (" %ld", (long)code[at - 2*i + 1]);
+    }
+    printf (" %s to %ld ", word->WrdName, (long)result);
+#endif
+
+    at -= 2*in;
+    code[at] = (cell)PrimNode[PRIM_LIT];
+    code[at+1] = result;
+    return at + 2;
+}
@@ -0,0 +1,265 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       profile.c
+ * \brief      Per word execution profiler
+ *
+ *             Execute() reports every word it nests into or calls, ProfEnter() and ProfLeave() keep a stack of
+ *             the words being timed next to the return stack. Each frame remembers the return stack depth of its
+ *             word, so a frame is only closed by the unnest of the word which opened it, however often
+ *             PROFILE-ON and PROFILE-OFF are used in between. The primitives the inner interpreter runs inline
+ *             count towards the word they are compiled into.
+ *
+ *             The counts of a user word are kept in its entry, those of the inbuilt words in \a RomCount as the
+ *             inbuilt words are in ROM.
+ *
+ *             Ticks are read with ReadCycles(): CPU cycles on the board, nanoseconds on the host. Reading them
+ *             costs time as well, so words which run only a handful of primitives look slower than they are.
+ *
+ *             None of this is built unless FORTH_PROFILE is set.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "CoreForth.h"
+#include "forthFunctions.h"
+#include "profile.h"
+
+#if FORTH_PROFILE
+
+#if defined(TARGET_LPC1768)
+#define PROFILE_UNIT        "cycles"
+#else
+#define PROFILE_UNIT        "ns"
+#endif
+
+struct ProfFrame {
+    NodePtr node;                           /**< Word being timed */
+    int rs;                                 /**< Return stack depth after nesting into it, PROFILE_INBUILT */
+    ucell start;                            /**< Ticks when it was entered */
+    ucell child;                            /**< Ticks spent in the words it called */
+};
+
+bool Profiling = FALSE;                     /**< Set by PROFILE-ON, Execute() only opens frames while set */
+int ProfTop;                                /**< Number of open frames */
+static struct ProfFrame ProfStack[PROFILE_DEPTH];
+static unsigned long ProfLost;              /**< Calls not timed because the frame stack was full */
+static struct ProfCount RomCount[ROM_WORDS_MAX];    /**< Counts of the inbuilt words, by RomIndex() */
+
+
+/**
+ *
+ * \fn          Counts(NodePtr node)
+ * \brief       Returns where the counts of a word are kept
+ *
+ */
+
+static struct ProfCount* Counts(NodePtr node) {
+    int i = RomIndex(node);
+
+    return i < 0 ? &node->prof : &RomCount[i];
+}
+
+
+/**
+ *
+ * \fn          ProfEnter(NodePtr node, int rs)
+ * \brief       Starts timing a word
+ *
+ * \param[in]   node    the word
+ * \param[in]   rs      return stack depth after nesting into it, PROFILE_INBUILT for inbuilt words
+ *
+ */
+
+void ProfEnter(NodePtr node, int rs) {
+    struct ProfFrame* fr;
+
+    if (ProfTop == PROFILE_DEPTH) {
+        ProfLost++;
+        return;
+    }
+    fr = &ProfStack[ProfTop++];
+    fr->node = node;
+    fr->rs = rs;
+    fr->child = 0;
+    Counts(node)->calls++;
+    Counts(node)->active++;
+    fr->start = ReadCycles();               // last, so that the book keeping is not charged to the word
+}
+
+
+/**
+ *
+ * \fn          ProfLeave(int rs)
+ * \brief       Stops timing the word which opened the top frame, if it was opened at return stack depth \a rs
+ *
+ */
+
+void ProfLeave(int rs) {
+    ucell now = ReadCycles();
+    struct ProfFrame* fr;
+    struct ProfCount* cnt;
+    ucell spent;
+
+    if (ProfTop == 0 || ProfStack[ProfTop-1].rs != rs) {
+        return;
+    }
+    fr = &ProfStack[--ProfTop];
+    spent = now - fr->start;
+    cnt = Counts(fr->node);
+    cnt->excl += spent - fr->child;
+    if (--cnt->active == 0) {
+        cnt->incl += spent;                 // a recursive word counts its outermost activation only
+    }
+    if (ProfTop > 0) {
+        ProfStack[ProfTop-1].child += spent;
+    }
+}
+
+
+/**
+ *
+ * \fn          ProfUnwind(int rs)
+ * \brief       Drops the frames of the words nested deeper than return stack depth \a rs, after an abort
+ *
+ */
+
+void ProfUnwind(int rs) {
+    while (ProfTop > 0 && ProfStack[ProfTop-1].rs > rs) {
+        Counts(ProfStack[--ProfTop].node)->active--;
+    }
+}
+
+
+/**
+ *
+ * \fn          ProfCall(NodePtr node)
+ * \brief       Calls an inbuilt word and times it
+ *
+ */
+
+void ProfCall(NodePtr node) {
+    int at = ProfTop;
+
+    ProfEnter(node, PROFILE_INBUILT);
+    (*node->func)();
+    if (ProfTop == at+1 && ProfStack[at].node == node) {    // PROFILE-ON clears the frames
+        ProfLeave(PROFILE_INBUILT);
+    }
+}
+
+
+/**
+ *  \fn      ProfileOn(void)
+ *  \brief   Clears the counts of every word and starts profiling
+ */
+
+void ProfileOn(void) {
+    NodePtr node;
+
+    for (node=LATEST; node!=NULL; node=node->next) {
+        memset(&node->prof, 0, sizeof(node->prof));
+    }
+    memset(RomCount, 0, sizeof(RomCount));
+    ProfTop = 0;
+    ProfLost = 0;
+    Profiling = TRUE;
+}
+
+
+/**
+ *  \fn      ProfileOff(void)
+ *  \brief   Stops profiling, the counts are kept for .PROFILE
+ */
+
+void ProfileOff(void) {
+    Profiling = FALSE;
+}
+
+
+/**
+ *  \fn      AddRow(NodePtr* rows, int n, NodePtr node)
+ *  \brief   Inserts a word into the rows of .PROFILE, most exclusive ticks first, the smallest drops out
+ *
+ *  \return  Number of rows
+ */
+
+static int AddRow(NodePtr* rows, int n, NodePtr node) {
+    int i;
+
+    for (i=n; i>0 && Counts(rows[i-1])->excl < Counts(node)->excl; i--) {
+        if (i < PROFILE_ROWS) {
+            rows[i] = rows[i-1];
+        }
+    }
+    if (i < PROFILE_ROWS) {
+        rows[i] = node;
+        if (n < PROFILE_ROWS) {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+
+/**
+ *  \fn      DotProfile(void)
+ *  \brief   Lists the words executed since PROFILE-ON, most exclusive ticks first
+ */
+
+void DotProfile(void) {
+    NodePtr rows[PROFILE_ROWS];
+    NodePtr node;
+    struct ProfCount* cnt;
+    unsigned long long total = 0;
+    int n = 0, i;
+
+    for (node=LATEST; node!=NULL; node=node->next) {
+        if (node->prof.calls != 0) {
+            total += node->prof.excl;
+            n = AddRow(rows, n, node);
+        }
+    }
+    for (i=0; i<RomWords+IoWords; i++) {
+        if (RomCount[i].calls != 0) {
+            total += RomCount[i].excl;
+            n = AddRow(rows, n, RomNode(i));
+        }
+    }
+
+    printf ("\n%-16s %10s %14s %14s %6s\n", "word", "calls", "incl " PROFILE_UNIT, "excl " PROFILE_UNIT, "excl%");
+    for (i=0; i<n; i++) {
+        cnt = Counts(rows[i]);
+        printf ("%-16s %10lu %14llu %14llu %5.1f%%\n", rows[i]->WrdName, cnt->calls, cnt->incl, cnt->excl,
+                total ? 100.0 * cnt->excl / total : 0.0);
+    }
+    printf ("%-16s %10s %14s %14llu\n", "total", "", "", total);
+    if (ProfLost) {
+        printf ("%lu calls nested too deep to be timed\n", ProfLost);
+    }
+}
+
+#endif
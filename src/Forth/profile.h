@@ -0,0 +1,55 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       profile.h
+ * \brief      Per word execution profiler, built in with FORTH_PROFILE
+ *
+ */
+
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#include "types.h"
+#include "CoreForth.h"
+
+#if FORTH_PROFILE
+
+#define PROFILE_DEPTH       64          /**< Nested words followed at once, deeper calls are counted as lost */
+#define PROFILE_ROWS        32          /**< .PROFILE lists this many words, those with the most exclusive ticks */
+#define PROFILE_INBUILT     -1          /**< Return stack depth recorded for an inbuilt word, it does not nest */
+
+extern bool Profiling;
+extern int ProfTop;
+
+void ProfEnter(NodePtr node, int rs);
+void ProfLeave(int rs);
+void ProfUnwind(int rs);
+void ProfCall(NodePtr node);
+void ProfileOn(void);
+void ProfileOff(void);
+void DotProfile(void);
+
+#endif
+
+#endif
@@ -36,15 +36,16 @@
 #include "stack.h"
 #include "CoreForth.h"
 
-int DatStack[STACK_DAT_SIZE];                           /**< Actual data stack */
-int RetStack[STACK_RET_SIZE];                           /**< Return stack */
+cell DatStackMem[STACK_DAT_SIZE+1];                     /**< Actual data stack, the first slot is a guard */
+cell* const DatStack = &DatStackMem[1];                 /**< Bottom of the data stack */
+cell RetStack[STACK_RET_SIZE];                          /**< Return stack */
 
 int DatStackTop;                                       /**< Top of stack pointer for data stack */
 int RetStackTop;                                       /**< Always points to top of return stack */
 
 /**
  *
- * \fn         PushDs(int dat, int* err_code)
+ * \fn         PushDs(cell dat, int* err_code)
  * \brief      Pushes a quantum of data into stack
  *
  *             This function pushes dat into data stack. It uses \a DatStackTop for push operstion.
@@ -57,7 +58,7 @@ int RetStackTop;                                       /**< Always points to top
  *
  */
 
-int PushDs (int dat, int* err_code) {
+int PushDs (cell dat, int* err_code) {
     int ret;
 
     /*
@@ -89,8 +90,8 @@ int PushDs (int dat, int* err_code) {
  *
  */
 
-int PopDs(int *err_code) {
-    int ret = STACK_ERR_EMPTY;
+cell PopDs(int *err_code) {
+    cell ret = STACK_ERR_EMPTY;
 
     if (DatStackTop == 0) {
         *err_code = STACK_ERR_EMPTY;
@@ -122,7 +123,7 @@ void DispDs(void) {
         printf ("\nData stack empty\n");
     } else {
         for (i=0; i<DatStackTop; i++) {
-            printf( "%d  ", DatStack[i]);
+            printf( CELL_FMT "  ", DatStack[i]);
         }
     }
 
@@ -130,7 +131,7 @@ void DispDs(void) {
 
 /**
  *
- * \fn           PushRs(int dat, int* err_code)
+ * \fn           PushRs(cell dat, int* err_code)
  * \brief        This function pushes data into Return stack
  *
  *               Return stack is used in FORTH to hold the address of a Word when a call to another word is made.
@@ -143,7 +144,7 @@ void DispDs(void) {
  *
  */
 
-int PushRs(int dat, int* err_code) {
+int PushRs(cell dat, int* err_code) {
     int ret;
 
     if (RetStackTop == STACK_RET_SIZE-1) {
@@ -172,8 +173,8 @@ int PushRs(int dat, int* err_code) {
  *
  */
 
-int PopRs(int* err_code) {
-    int ret =  STACK_ERR_EMPTY;
+cell PopRs(int* err_code) {
+    cell ret =  STACK_ERR_EMPTY;
 
     if (RetStackTop == 0) {
         *err_code = STACK_ERR_EMPTY;
@@ -206,7 +207,7 @@ void DispRs(void) {
         printf ("return stack empty\n");
     } else {
         for (i=0; i<RetStackTop; i++) {
-            printf ("%d\t", RetStack[i]);
+            printf (CELL_FMT "\t", RetStack[i]);
         }
     }
 
@@ -34,6 +34,8 @@
 #ifndef __STACK_H
 #define __STACK_H
 
+#include "types.h"
+
 #define STACK_DAT_SIZE     50         /**< The maximum size of the data stack */
 #define STACK_RET_SIZE     50         /**< The maximum size of the return stack */
 
@@ -41,11 +43,21 @@
 #define STACK_ERR_SUCCESS   1         /**< code retuned if data was successfully inserted into stack */
 #define STACK_ERR_EMPTY     2         /**< error code returned if stack is empty */
 
+/**
+ * The inner interpreter keeps the top of stack in a local and writes it back to the slot just above the
+ * second item. With an empty stack that slot is DatStack[-1], so one guard cell is reserved below the stack.
+ */
+
+extern cell* const DatStack;
+extern int DatStackTop;
+extern cell RetStack[STACK_RET_SIZE];
+extern int RetStackTop;
+
 void DispDs(void);
-int PopDs(int *err_code);
-int PushDs (int dat, int* err_code);
-int PushRs(int dat, int* err_code);
-int PopRs(int* err_code);
+cell PopDs(int *err_code);
+int PushDs (cell dat, int* err_code);
+int PushRs(cell dat, int* err_code);
+cell PopRs(int* err_code);
 void DispRs(void);
 
 
@@ -0,0 +1,394 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       token.c
+ * \brief      Token threaded code, built in with FORTH_TOKEN_CODE
+ *
+ *             Words are compiled into cells as usual, one per word and operand, and packed into 16 bit code_units
+ *             by EncodeWord() once they are finished and optimised:
+ *
+ *             - a primitive becomes its number, below TOKEN_CALL, Execute() dispatches on it without looking at
+ *               the dictionary entry
+ *             - any other inbuilt word becomes its index in ROM, RomIndex(), below TOKEN_WORD
+ *             - a user word becomes TOKEN_WORD plus the cell of DicArena its entry starts at
+ *             - branch offsets, counted in units, and the span of a (CASE) jump table take a unit
+ *             - the operands of LIT, (LIT+) and (LIT@) and the lowest value of a jump table take a cell, aligned
+ *               to a unit only
+ *             - the string of STR takes a unit for every two characters, the 0 after them included
+ *             - END_CODE ends the code
+ *
+ *             On the board a cell is 4 bytes, the code of a word takes a little more than half of what it did,
+ *             for an address computation per user word called. The arena can be 65280 cells at most.
+ *
+ */
+
+#include <string.h>
+#include "CoreForth.h"
+#include "interprter.h"
+#include "optimise.h"
+#include "token.h"
+
+#if FORTH_TOKEN_CODE
+
+#define OPND_CELL       0               /**< Operand packed into a cell */
+#define OPND_UNIT       1               /**< Operand packed into a unit, the span of a jump table */
+#define OPND_OFFSET     2               /**< Branch offset, counted in cells before and in units after packing */
+#define OPND_WORD       3               /**< Word operand of (TAIL), packed into its token */
+
+#define UNIT_CHARS      ((int)sizeof(code_unit))    /**< Characters of a string packed into a unit */
+
+static NodePtr StrNode;                 /**< Entry of STR, its operand is a string */
+
+
+/**
+ *
+ * \fn          OperandKind(NodePtr word, int k)
+ * \brief       Returns how operand \a k, counting from 0, of a word other than STR is packed
+ *
+ */
+
+static int OperandKind(NodePtr word, int k) {
+    switch (PRIM_BASE(word->prim)) {
+    case PRIM_LIT:
+    case PRIM_LIT_ADD:
+    case PRIM_LIT_FETCH:
+        return OPND_CELL;
+    case PRIM_TAIL:
+        return OPND_WORD;
+    case PRIM_CASE:
+        return k == 0 ? OPND_CELL : k == 1 ? OPND_UNIT : OPND_OFFSET;
+    default:
+        return OPND_OFFSET;             // the branches, nothing else has operands
+    }
+}
+
+
+/**
+ *
+ * \fn          PackStr(cell* str, int n, code_unit* out)
+ * \brief       Packs the characters of \a n cells of a string operand up to its 0 into units
+ *
+ *              \a out may overlap \a str as long as it does not start after it. Only counts if \a out is NULL.
+ *
+ * \return      Number of units
+ *
+ */
+
+static int PackStr(cell* str, int n, code_unit* out) {
+    ucell packed;
+    int i, b, c = 0;
+
+    for (i=0; i<n; i++) {
+        packed = str[i];                            // read before the units written over it
+        for (b=0; b<(int)sizeof(cell); b++, packed >>= 8) {
+            if (out != NULL) {
+                out[c / UNIT_CHARS] = (c % UNIT_CHARS == 0 ? 0 : out[c / UNIT_CHARS]) |
+                                      (code_unit)((packed & 0xff) << (8 * (c % UNIT_CHARS)));
+            }
+            c++;
+            if (!(packed & 0xff)) {
+                return (c + UNIT_CHARS - 1) / UNIT_CHARS;
+            }
+        }
+    }
+
+    return (c + UNIT_CHARS - 1) / UNIT_CHARS;
+}
+
+
+/**
+ *
+ * \fn          GroupUnits(cell* code, int i, int len)
+ * \brief       Returns the number of units the word at \a i and its operands are packed into
+ *
+ */
+
+static int GroupUnits(cell* code, int i, int len) {
+    NodePtr word = (NodePtr)code[i];
+    int k, n, units = 1;
+
+    n = OperandCells(code, i, len);
+    if (word == StrNode) {
+        return 1 + PackStr(&code[i+1], n, NULL);
+    }
+    for (k=0; k<n; k++) {
+        units += OperandKind(word, k) == OPND_CELL ? CELL_UNITS : 1;
+    }
+
+    return units;
+}
+
+
+/**
+ *
+ * \fn          UnitAt(cell* code, int len, int at)
+ * \brief       Returns where the word at cell \a at ends up once \a code is packed
+ *
+ */
+
+static int UnitAt(cell* code, int len, int at) {
+    int i, u = 0;
+
+    for (i=0; i<at && i<len; i += 1 + OperandCells(code, i, len)) {
+        u += GroupUnits(code, i, len);
+    }
+
+    return u;
+}
+
+
+/**
+ *
+ * \fn          EncodeWord(NodePtr node, int len)
+ * \brief       Packs the code of a finished word into tokens, in place
+ *
+ *              The branch offsets are turned into units first, while all the cells are still there. Packing
+ *              never takes more bytes than the cells packed, so the units are written front to back over the
+ *              cells and \a DicHere is pulled back to the end of them if nothing follows the latest word yet.
+ *
+ * \param[in]   node  the entry, its code compiled, fused and verified
+ * \param[in]   len   number of code cells, not counting END_WORD
+ *
+ * \return      Number of units, not counting END_CODE
+ *
+ */
+
+int EncodeWord(NodePtr node, int len) {
+    cell* code = node->code;
+    code_unit* out = (code_unit*)code;
+    NodePtr word;
+    cell val;
+    int i, k, n, u, at;
+
+    if (code == NULL) {
+        return 0;
+    }
+    if (StrNode == NULL) {
+        Find("STR", (cell*)&StrNode);
+    }
+
+    for (i=0; i<len; i += 1 + n) {
+        word = (NodePtr)code[i];
+        n = OperandCells(code, i, len);
+        if (word == StrNode) {
+            continue;
+        }
+        for (k=0, at=UnitAt(code, len, i) + 1; k<n; at += OperandKind(word, k) == OPND_CELL ? CELL_UNITS : 1, k++) {
+            if (OperandKind(word, k) == OPND_OFFSET) {
+                code[i+1+k] = UnitAt(code, len, i+1+k + code[i+1+k]) - at;
+            }
+        }
+    }
+
+    for (i=0, u=0; i<len; i += 1 + n) {
+        word = (NodePtr)code[i];
+        n = OperandCells(code, i, len);
+        out[u++] = TOKEN_OF(word);
+        if (word == StrNode) {
+            u += PackStr(&code[i+1], n, &out[u]);
+            continue;
+        }
+        for (k=0; k<n; k++) {
+            val = code[i+1+k];
+            switch (OperandKind(word, k)) {
+            case OPND_CELL:
+                memmove(&out[u], &val, sizeof(cell));
+                u += CELL_UNITS;
+                break;
+            case OPND_WORD:
+                out[u++] = TOKEN_OF((NodePtr)val);
+                break;
+            default:
+                out[u++] = (code_unit)val;
+                break;
+            }
+        }
+    }
+    out[u] = END_CODE;
+
+    if (node == LATEST) {                           // not a line compiled at the prompt, see Interpret()
+        ShrinkDicEntry((char*)&out[u+1]);
+    }
+    return u;
+}
+
+
+/**
+ *
+ * \fn          Operands(NodePtr word, code_unit* ip, int* units)
+ * \brief       Returns the number of operand cells of the word whose token is before \a ip and sets \a units
+ *              to the units they are packed into
+ *
+ */
+
+static int Operands(NodePtr word, code_unit* ip, int* units) {
+    int k, n, c;
+
+    if (word == StrNode) {
+        for (c=0; (ip[c / UNIT_CHARS] >> (8 * (c % UNIT_CHARS))) & 0xff; c++) {
+        }
+        c++;                                        // the 0
+        *units = (c + UNIT_CHARS - 1) / UNIT_CHARS;
+        return (c + (int)sizeof(cell) - 1) / (int)sizeof(cell);
+    }
+
+    switch (PRIM_BASE(word->prim)) {
+    case PRIM_LIT: case PRIM_LIT_ADD: case PRIM_LIT_FETCH: case PRIM_TAIL: case PRIM_BRANCH: case PRIM_0BRANCH:
+    case PRIM_0EQ_0BRANCH: case PRIM_QDO: case PRIM_LOOP: case PRIM_PLOOP:
+        n = 1;
+        break;
+    case PRIM_CASE:
+        n = 3 + ip[CELL_UNITS];                     // min, span, the offsets and the default
+        break;
+    default:
+        n = 0;
+        break;
+    }
+    for (k=0, *units=0; k<n; k++) {
+        *units += OperandKind(word, k) == OPND_CELL ? CELL_UNITS : 1;
+    }
+
+    return n;
+}
+
+
+/**
+ *
+ * \fn          OperandUnits(code_unit* ip)
+ * \brief       Returns the number of units of operands following the token at \a ip
+ *
+ */
+
+int OperandUnits(code_unit* ip) {
+    int units;
+
+    if (StrNode == NULL) {
+        Find("STR", (cell*)&StrNode);
+    }
+    Operands(TOKEN_NODE(*ip), ip + 1, &units);
+
+    return units;
+}
+
+
+/**
+ *
+ * \fn          DecodeWord(NodePtr node, cell* dest, int room)
+ * \brief       Unpacks the code of a word back into cells, for InlineCode()
+ *
+ *              The branches are first given the unit they land on, turned into cell offsets once the cells are
+ *              all there. Unchecked primitives stay unchecked, END_WORD is written after the code.
+ *
+ * \param[in]   node  a finished user word
+ * \param[out]  dest  where the cells go
+ * \param[in]   room  most cells which may be written to \a dest, END_WORD not counted
+ *
+ * \return      Number of cells, 0 if they are more than \a room
+ *
+ */
+
+int DecodeWord(NodePtr node, cell* dest, int room) {
+    code_unit *code = (code_unit*)node->code, *ip = code;
+    NodePtr word;
+    int i, k, n, c, units, len = 0;
+
+    if (StrNode == NULL) {
+        Find("STR", (cell*)&StrNode);
+    }
+
+    while (*ip != END_CODE) {
+        word = TOKEN_NODE(*ip);
+        ip++;
+        n = Operands(word, ip, &units);
+        if (len + 1 + n > room) {
+            return 0;
+        }
+        dest[len++] = (cell)word;
+
+        if (word == StrNode) {
+            for (c=0; c < n * (int)sizeof(cell); c++) {
+                if (c % sizeof(cell) == 0) {
+                    dest[len + c / sizeof(cell)] = 0;
+                }
+                if (c < units * UNIT_CHARS) {
+                    dest[len + c / sizeof(cell)] |= (cell)((ip[c / UNIT_CHARS] >> (8 * (c % UNIT_CHARS))) & 0xff)
+                                                   << (8 * (c % sizeof(cell)));
+                }
+            }
+            len += n;
+            ip += units;
+            continue;
+        }
+
+        for (k=0; k<n; k++) {
+            switch (OperandKind(word, k)) {
+            case OPND_CELL:
+                dest[len++] = CODE_CELL(ip);
+                ip += CELL_UNITS;
+                break;
+            case OPND_WORD:
+                dest[len++] = (cell)CODE_XT(ip);
+                ip++;
+                break;
+            case OPND_OFFSET:
+                dest[len++] = (ip - code) + CODE_OFFSET(ip);    // unit it lands on for now
+                ip++;
+                break;
+            default:
+                dest[len++] = *ip++;
+                break;
+            }
+        }
+    }
+    dest[len] = END_WORD;
+
+    for (i=0; i<len; i += 1 + n) {
+        word = (NodePtr)dest[i];
+        n = OperandCells(dest, i, len);
+        for (k=0; k<n && word != StrNode; k++) {
+            if (OperandKind(word, k) == OPND_OFFSET) {
+                for (c=0, units=0; c<len && units<dest[i+1+k]; c += 1 + OperandCells(dest, c, len)) {
+                    units += GroupUnits(dest, c, len);
+                }
+                dest[i+1+k] = c - (i+1+k);
+            }
+        }
+    }
+
+    return len;
+}
+
+
+/**
+ *
+ * \fn          PatchLit(NodePtr node, cell val)
+ * \brief       Sets the operand of the LIT the code of \a node starts with, for VARIABLE and MARKER
+ *
+ */
+
+void PatchLit(NodePtr node, cell val) {
+    memcpy((code_unit*)node->code + 1, &val, sizeof(cell));
+}
+
+#endif
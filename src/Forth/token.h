@@ -0,0 +1,89 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       token.h
+ * \brief      Token threaded code, built in with FORTH_TOKEN_CODE
+ *
+ *             The inner interpreter and the inbuilt words reading operands at \a IP go through the macros here, so
+ *             that they work on either representation of the code.
+ *
+ */
+
+#ifndef __TOKEN_H
+#define __TOKEN_H
+
+#include <string.h>
+#include "types.h"
+#include "CoreForth.h"
+
+#if FORTH_TOKEN_CODE
+
+#define TOKEN_CALL          (2*PRIM_COUNT)                  /**< First token which is not a primitive, inbuilt words are RomIndex() */
+#define TOKEN_OF(node)      TokenOf(node)                   /**< Token compiled for an entry */
+#define TOKEN_NODE(t)       ((t) >= TOKEN_WORD ? (NodePtr)&DicArena[(t) - TOKEN_WORD] : RomNode(t))   /**< Inverse of TOKEN_OF() */
+
+#define CODE_OFFSET(ip)     ((cell)(int16_t)*(ip))          /**< Branch offset at \a ip */
+#define CODE_CELL(ip)       CodeCell(ip)                    /**< Cell operand at \a ip, CELL_UNITS long */
+#define CODE_XT(ip)         TOKEN_NODE(*(ip))               /**< Word operand at \a ip */
+
+/**
+ * \fn          TokenOf(NodePtr node)
+ * \brief       An inbuilt word is its index in ROM, the primitives coming first, any other word its cell in the arena
+ */
+
+static inline code_unit TokenOf(NodePtr node) {
+    int i = RomIndex(node);
+
+    return (code_unit)(i >= 0 ? i : (cell*)node - DicArena + TOKEN_WORD);
+}
+
+/**
+ * \fn          CodeCell(const code_unit* ip)
+ * \brief       Reads a cell operand, which is only aligned to a code_unit
+ */
+
+static inline cell CodeCell(const code_unit* ip) {
+    cell val;
+
+    memcpy(&val, ip, sizeof(cell));
+    return val;
+}
+
+int EncodeWord(NodePtr node, int len);
+int DecodeWord(NodePtr node, cell* dest, int room);
+int OperandUnits(code_unit* ip);
+void PatchLit(NodePtr node, cell val);
+
+#else
+
+#define CODE_OFFSET(ip)     (*(ip))
+#define CODE_CELL(ip)       (*(ip))
+#define CODE_XT(ip)         ((NodePtr)*(ip))
+
+#define EncodeWord(node, len)   ((void)0)                   /**< The code stays as it was compiled */
+#define PatchLit(node, val)     ((node)->code[1] = (val))   /**< Sets the operand of the LIT \a node starts with */
+
+#endif
+
+#endif
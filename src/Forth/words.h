@@ -0,0 +1,187 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ *
+ * \file       words.h
+ * \brief      The inbuilt words, listed once for the enum of the primitives and the dictionary in ROM
+ *
+ *             Each list is an X-macro: it is expanded with a macro taking the columns of a row.
+ *
+ *             FORTH_PRIMS(X) has the primitives the inner interpreter executes itself, in the order of enum
+ *             forth_prim, as X(id, name, func, flags, in, out, checks). id names the primitive PRIM_id, in and
+ *             out are its stack effect and checks is 0 for the primitives without stack checks to leave out,
+ *             they get no unchecked variant.
+ *
+ *             FORTH_WORDS(X) has the other inbuilt words and FORTH_IO_WORDS(X) those driving the GUI and the
+ *             peripherals of the board, as X(name, func, flags, in, out). A word whose stack effect is not
+ *             fixed has STK_UNKNOWN for in.
+ *
+ *             flags are added to FORTH_WORD_INBUILT. VerifyWord() infers the stack effects of user words from
+ *             those listed here, and the colon compiler folds the words marked FORTH_WORD_PURE over literals.
+ *             The words marked FORTH_WORD_ALONE read the line after them, change how it is read or forget words,
+ *             Interpret() runs what it compiled of the line before executing one of them on its own.
+ *
+ */
+
+#ifndef __WORDS_H
+#define __WORDS_H
+
+#define FORTH_PRIMS(X) \
+    X(LIT,          "LIT",          Lit,            0,                  0, 1, 1) \
+    X(BRANCH,       "BRANCH",       UnCondBranch,   0,                  0, 0, 0) \
+    X(0BRANCH,      "0BRANCH",      CondBranch,     0,                  1, 0, 1) \
+    X(ADD,          "+",            Add,            FORTH_WORD_PURE,    2, 1, 1) \
+    X(SUB,          "-",            Sub,            FORTH_WORD_PURE,    2, 1, 1) \
+    X(MUL,          "*",            Mul,            FORTH_WORD_PURE,    2, 1, 1) \
+    X(DIV,          "/",            Div,            FORTH_WORD_PURE,    2, 1, 1) \
+    X(DUP,          "DUP",          Dup,            0,                  1, 2, 1) \
+    X(DROP,         "DROP",         Drop,           0,                  1, 0, 1) \
+    X(SWAP,         "SWAP",         Swap,           0,                  2, 2, 1) \
+    X(OVER,         "OVER",         Over,           0,                  2, 3, 1) \
+    X(FETCH,        "@",            Read,           0,                  1, 1, 1) \
+    X(STORE,        "!",            Write,          0,                  2, 0, 1) \
+    X(EQ,           "=",            Equal,          FORTH_WORD_PURE,    2, 1, 1) \
+    X(LT,           "<",            LT,             FORTH_WORD_PURE,    2, 1, 1) \
+    X(GT,           ">",            GT,             FORTH_WORD_PURE,    2, 1, 1) \
+    X(LTE,          "<=",           LTE,            FORTH_WORD_PURE,    2, 1, 1) \
+    X(GTE,          ">=",           GTE,            FORTH_WORD_PURE,    2, 1, 1) \
+    X(NOT,          "NOT",          Not,            FORTH_WORD_PURE,    1, 1, 1) \
+    X(AND,          "AND",          And,            FORTH_WORD_PURE,    2, 1, 1) \
+    X(OR,           "OR",           Or,             FORTH_WORD_PURE,    2, 1, 1) \
+    X(XOR,          "XOR",          Xor,            FORTH_WORD_PURE,    2, 1, 1) \
+    X(BITSET,       "?BITSET",      BitSet,         FORTH_WORD_PURE,    2, 1, 1) \
+    /* fused by the optimiser: LIT n +, LIT addr @, DUP *, LIT 0 = 0BRANCH and OVER OVER */ \
+    X(LIT_ADD,      "(LIT+)",       LitAdd,         0,                  1, 1, 1) \
+    X(LIT_FETCH,    "(LIT@)",       LitFetch,       0,                  0, 1, 1) \
+    X(DUP_MUL,      "(DUP*)",       DupMul,         0,                  1, 1, 1) \
+    X(0EQ_0BRANCH,  "(0=0BRANCH)",  ZeroEqBranch,   0,                  1, 0, 1) \
+    X(2DUP,         "(2DUP)",       TwoDup,         0,                  2, 4, 1) \
+    /* counted loops: (?DO) and the loop ends take a branch offset, the parameters live on the return stack */ \
+    X(DO,           "(DO)",         DoParams,       0,                  2, 0, 1) \
+    X(QDO,          "(?DO)",        QueryDoParams,  0,                  2, 0, 1) \
+    X(LOOP,         "(LOOP)",       LoopBranch,     0,                  0, 0, 1) \
+    X(PLOOP,        "(+LOOP)",      PlusLoopBranch, 0,                  1, 0, 1) \
+    X(I,            "(I)",          LoopIndex,      0,                  0, 1, 1) \
+    X(J,            "(J)",          OuterIndex,     0,                  0, 1, 1) \
+    X(UNLOOP,       "(UNLOOP)",     UnloopParams,   0,                  0, 0, 1) \
+    /* (CASE) min span offsets, the jump table of a dense CASE, and (TAIL) xt, a call reusing the frame */ \
+    X(CASE,         "(CASE)",       CaseBranch,     0,                  1, 1, 1) \
+    X(TAIL,         "(TAIL)",       TailCall,       0,                  STK_UNKNOWN, 0, 0)
+
+#define FORTH_WORDS(X) \
+    X(":",          ColonFunc,      FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X(".",          Dot,            0,                                      1, 0) \
+    X(".S",         DotS,           0,                                      0, 0) \
+    X("BASE",       BaseSet,        FORTH_WORD_ALONE,                       1, 0) \
+    X("EXIT",       Exit,           0,                                      STK_UNKNOWN, 0) \
+    X("VARIABLE",   Create,         FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X("C@",         CFetch,         0,                                      1, 1) \
+    X("C!",         CStore,         0,                                      2, 0) \
+    X("CELLS",      Cells,          0,                                      1, 1) \
+    X("?BASE",      QueryBase,      0,                                      STK_UNKNOWN, 0) \
+    X("IF",         If,             FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("THEN",       Then,           FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("ELSE",       Else,           FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("BEGIN",      Begin,          FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("UNTIL",      Until,          FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("WHILE",      While,          FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("REPEAT",     Repeat,         FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("AGAIN",      Again,          FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("RECURSE",    Recurse,        FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("DO",         Do,             FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("?DO",        QueryDo,        FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("LOOP",       Loop,           FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("+LOOP",      PlusLoop,       FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("I",          CompileI,       FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("J",          CompileJ,       FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("LEAVE",      Leave,          FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("UNLOOP",     Unloop,         FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("CASE",       Case,           FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("OF",         Of,             FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("ENDOF",      EndOf,          FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("ENDCASE",    EndCase,        FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X(";",          StopCompile,    FORTH_WORD_IMED,                        STK_UNKNOWN, 0) \
+    X("STR",        DispStr,        0,                                      0, 0) \
+    X(".\"",        DotStr,         FORTH_WORD_IMED | FORTH_COMPILE_ONLY,   STK_UNKNOWN, 0) \
+    X("\\",         SkipComment1,   FORTH_WORD_IMED,                        STK_UNKNOWN, 0) \
+    X("(",          SkipComment2,   FORTH_WORD_IMED,                        STK_UNKNOWN, 0) \
+    X("?BITCLEAR",  BitClear,       FORTH_WORD_PURE,                        2, 1) \
+    X("CR",         Cr,             0,                                      0, 0) \
+    X("FLUSH",      Flush,          0,                                      0, 0) \
+    X(".FUSED",     DotFused,       0,                                      STK_UNKNOWN, 0) \
+    X("INLINE",     Inline,         0,                                      STK_UNKNOWN, 0) \
+    X("NOINLINE",   NoInline,       0,                                      STK_UNKNOWN, 0) \
+    X("HERE",       Here,           0,                                      0, 1) \
+    X("ALLOT",      Allot,          0,                                      1, 0) \
+    X(",",          Comma,          0,                                      1, 0) \
+    X("C,",         CComma,         0,                                      1, 0) \
+    X("FORGET",     Forget,         FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X("MARKER",     Marker,         FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X("(FORGET)",   ForgetXt,       FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X("CYCLES",     Cycles,         0,                                      0, 1) \
+    FORTH_PROFILE_WORDS(X) \
+    X("ADDTICKER",  AddTicker,      FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X("FLOAD",      Fload,          FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X("SAVE-IMAGE", SaveImageWord,  FORTH_WORD_ALONE,                       STK_UNKNOWN, 0)
+
+#if FORTH_PROFILE
+#define FORTH_PROFILE_WORDS(X) \
+    X("PROFILE-ON", ProfileOn,      0,                                      STK_UNKNOWN, 0) \
+    X("PROFILE-OFF", ProfileOff,    0,                                      STK_UNKNOWN, 0) \
+    X(".PROFILE",   DotProfile,     0,                                      STK_UNKNOWN, 0)
+#else
+#define FORTH_PROFILE_WORDS(X)
+#endif
+
+#define FORTH_IO_WORDS(X) \
+    X("ML",         MainLoop,       0,                                      STK_UNKNOWN, 0) \
+    X("CRT_BTN",    CreateBtn,      FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X("SHOW",       ShowWidgets,    0,                                      STK_UNKNOWN, 0) \
+    X("CRT_P_BAR",  CreatePBar,     FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X("SET_P_BAR",  SetPBar,        0,                                      STK_UNKNOWN, 0) \
+    X("CRT_ST_TXT", CreateStTxt,    FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X("SET_ST_TXT", SetStTxt,       0,                                      STK_UNKNOWN, 0) \
+    X("SET_ST_CLR", SetStClr,       0,                                      STK_UNKNOWN, 0) \
+    X("DIGITALOUT", SetPort,        0,                                      STK_UNKNOWN, 0) \
+    X("DIGITALIN",  ReadPort,       0,                                      STK_UNKNOWN, 0) \
+    X("ANALOGIN",   AnalogRead,     0,                                      STK_UNKNOWN, 0) \
+    X("ANALOGOUT",  AnalogWrite,    0,                                      STK_UNKNOWN, 0) \
+    X("EXIT_ML",    ExitMainLoop,   0,                                      STK_UNKNOWN, 0) \
+    X("CRT_BMP",    AddBmp,         FORTH_WORD_ALONE,                       STK_UNKNOWN, 0) \
+    X("SET_BMP",    SetBmp,         0,                                      STK_UNKNOWN, 0) \
+    X("CLR_GUI",    ClearGui,       0,                                      STK_UNKNOWN, 0) \
+    X("SPIWRITE",   SpiWrite,       0,                                      STK_UNKNOWN, 0)
+
+/* rows of the dictionary in ROM, see RomDic */
+
+#define ROM_PEAK(in, out)   ((in) != STK_UNKNOWN && (out) > (in) ? (out) - (in) : 0)
+
+#define ROM_ROW(name, func, flags, prim, in, out) \
+    { name, FORTH_WORD_INBUILT | (flags), NULL, NULL, (int)sizeof(name) - 1, func, NULL, prim, in, out, ROM_PEAK(in, out) },
+
+#define ROM_WORD(name, func, flags, in, out)                ROM_ROW(name, &func, flags, PRIM_NONE, in, out)
+#define ROM_PRIM(id, name, func, flags, in, out, checks)    ROM_ROW(name, &func, flags, PRIM_##id, in, out)
+#define ROM_UNCHECKED(id, name, func, flags, in, out, checks) \
+    ROM_ROW("~" name, &func, flags, PRIM_UNCHECKED(PRIM_##id), in, out)
+
+#endif
@@ -146,6 +146,7 @@ int AddButton(uint32_t id, char* name, char* caption, char* cb_word, int x, int
     }
     strcpy(temp_btn->caption, name);
     strcpy (temp_btn->call_back_word, cb_word);
+    temp_btn->call_back_xt = 0;                 // looked up when the button is first pressed
     gui_ptr->height = BTN_HT;
     gui_ptr->width  = BTN_WT;
     gui_ptr->gui_struct = (void*)temp_btn;      // store the info related to btn
@@ -474,23 +475,24 @@ int UpdateBMP(uint32_t id, char *file_name) {
 /**
  * This function dispatches a event to any control
  *
- * @param[out]   cb_wrd    on exit from this function this array will have call back
- *                         word if there was an event on any button
+ * @param[out]   btn_info  on exit from this function this will point to the button if there was an
+ *                         event on any button
  *
  * @return   EVENT if there was an event on a button NO_EVENT if no event is pending
  */
 
 
-int Dispatcher(char* cb_wrd, int *id) {
+int Dispatcher(btn** btn_info, int *id) {
     gui_elem_ptr temp;
     ts_event evt;
     int a, b;
 
-    // poll for an event to occur
-    evt.x = -1;
+    *btn_info = NULL;
 
-    while (evt.x == -1) {
-        get_evt(&evt);
+    // poll for an event, the caller keeps polling so that it can do other work in between
+    get_evt(&evt);
+    if (evt.x == -1) {
+        return NO_EVENT;
     }
 
     temp = GUI_FIRST;
@@ -501,22 +503,42 @@ int Dispatcher(char* cb_wrd, int *id) {
             b = temp->y+temp->width;
             if ((evt.x < a && evt.y < b) && (evt.x > temp->x &&  evt.y > temp->y) ) {
                 //printf ("\rWe have an event on %s       ", temp->name);
-                btn *btn_info = (btn*)temp->gui_struct;
-                strcpy(cb_wrd, btn_info->call_back_word);
+                *btn_info = (btn*)temp->gui_struct;
                 *id = temp->id;
-                GuiButton(temp->x, temp->y, temp->width, temp->height, btn_info->caption, CLICKED);          // for the click effect
+                GuiButton(temp->x, temp->y, temp->width, temp->height, (*btn_info)->caption, CLICKED);          // for the click effect
                 wait(0.2);
-                GuiButton(temp->x, temp->y, temp->width, temp->height, btn_info->caption, UNCLICKED);
+                GuiButton(temp->x, temp->y, temp->width, temp->height, (*btn_info)->caption, UNCLICKED);
                 return EVENT;
             }
         }
         temp = temp->next;
     }
-    cb_wrd[0] = '\0';
     return NO_EVENT;
 }
 
 
+/**
+ * This function forgets the execution tokens of call back words which were removed from the dictionary,
+ * they are looked up again by name on the next press
+ *
+ * @param[in]   limit    words at or above this address are gone
+ */
+
+void DropBtnCallbacks(char* limit) {
+    gui_elem_ptr temp;
+    btn *btn_info;
+
+    for (temp = GUI_FIRST; temp != NULL; temp = temp->next) {
+        if (temp->gui_type == BUTTON) {
+            btn_info = (btn*)temp->gui_struct;
+            if ((char*)btn_info->call_back_xt >= limit) {
+                btn_info->call_back_xt = 0;
+            }
+        }
+    }
+}
+
+
 /**
 * This function deletes all the elements in the GUI_LIST.
 * This is the destructor for all the GUI elemnts.
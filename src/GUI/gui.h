@@ -53,7 +53,8 @@ int SetStColor(uint32_t id, uint32_t fg, uint32_t bg) ;
 void DrawControls(void);
 int AddBMP(uint32_t id, char* name, uint32_t x, uint32_t y, char* file_path);
 int UpdateBMP(uint32_t id, char *file_name);
-int Dispatcher(char* cb_wrd, int *id);
+int Dispatcher(btn** btn_info, int *id);
+void DropBtnCallbacks(char* limit);
 void RmGuiElemAll(void);
 #endif
 
@@ -87,6 +87,7 @@ typedef struct p_bar p_bar;
 struct btn {
     char caption[CAP_SIZE];                 /*< Caption of the button */
     char call_back_word[MAX_WRD_SIZE];      /*< To hold call back word when event occurs on this button */
+    cell call_back_xt;                      /*< Execution token of the call back word, 0 until it is first looked up */
 };
 
 typedef struct btn btn;
@@ -29,62 +29,25 @@
 #include "interprter.h"
 #include "utils.h"
 #include "forth_files.h"
+#include "console.h"
 
 
 
 
 
-Serial pc(USBTX, USBRX);
-
-
 extern int CmdPos;
-extern char CmdBuff[];
+extern char* CmdBuff;
 
 
 DigitalOut myled(LED1);
 
-/**
-* This function simply reads the input strings from the console.
-*
-* @param      ip     buffer to hold the input string
-* @param     size    The maximum number of bytes ip can hold
-*
-*/
-
-void GetStr(char* ip, int size) {
-    int i;
-    i = 0;
-    char temp;
-
-    while (1) {
-        if (pc.readable()) {
-            temp = pc.getc();
-            pc.putc(temp);
-            if (temp == 0x0d) {
-                break;
-            }
-
-            if (temp == 8 ) {  // back space
-                if (i > 0) {
-                    i--;
-                }
-                continue;
-            }
-
-            ip[i] = temp;
-            i++;
-        }
-    }
-    ip[i] = '\0';
-}
-
-
 int main() {
     char msg[] = "Reconfigurable computing \nmbed design challenge entry: NXP3878 \n";
     int res;
     init_dictionary();
     RESET_CMDPOS;
     printf (msg);
+    ConsoleInit();                      // buffer what is typed while the init scripts run
     LCD_Init();
     LCD_Clear(WHITE);
     TS_init();
@@ -94,12 +57,14 @@ int main() {
 
     while (1) {
 
-        GetStr(CmdBuff, 50);
-        ToUp(CmdBuff);
+        while (ReadLine(TermBuff, BUFFER_SIZE) == FALSE) {
+            ServiceTicker();            // ticker words run here while we wait
+            WaitForInput();
+        }
 
         res = CONTINUE_FORTH_INTERPRET;
 
-        while (CmdBuff[CmdPos] != '\0') {
+        while (!IS_EOL(CmdBuff[CmdPos])) {
             res = Interpret();
             if (res == COMPILE_ERROR || res == STOP_FORTH_INTERPRET ) {
                 break;
@@ -0,0 +1,258 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+*  @file    console.c
+*  @brief   Serial console of the board
+*
+*           The UART receive interrupt puts every character into a ring buffer
+*           as soon as it arrives, so nothing is lost while the VM is busy
+*           running a word or painting the LCD. The main loop takes the
+*           characters out and edits a line with them without ever waiting,
+*           see ReadLine(). Only the interrupt moves the head of the ring and
+*           only the main loop its tail, so neither needs a lock.
+*
+*           Output goes the other way. stdout is sent to a ring which the UART
+*           transmit interrupt empties, so printf() returns as soon as the text
+*           is in the ring instead of after it went out at 9600 baud. What
+*           happens when the ring is full is set by FORTH_TX_DROP. FLUSH waits
+*           until everything was sent.
+*/
+
+#include "mbed.h"
+#include "console.h"
+#include "forthFunctions.h"
+
+Serial pc(USBTX, USBRX);
+
+static char RxRing[FORTH_RX_SIZE];
+static volatile int RxHead;             /*< Next free byte, moved by RxIsr() only */
+static volatile int RxTail;             /*< Next byte to read, moved by ReadLine() only */
+static volatile int RxLost;             /*< Bytes dropped with the ring full */
+
+static char TxRing[FORTH_TX_SIZE];
+static volatile int TxHead;             /*< Next free byte, moved by PutTx() only */
+static volatile int TxTail;             /*< Next byte to send, moved by TxIsr() only */
+static volatile int TxIdle = TRUE;      /*< The ring is empty and no transmit interrupt will come */
+static volatile int TxLost;             /*< Bytes dropped with the ring full, with FORTH_TX_DROP */
+
+static int LinePos;                     /*< Characters on the line being edited */
+static char LineEnd;                    /*< CR or LF which ended the last line */
+
+
+/**
+* Receive interrupt, moves everything the UART holds into the ring.
+*/
+
+static void RxIsr(void) {
+    int next;
+    char c;
+
+    while (pc.readable()) {
+        c = pc.getc();
+        next = (RxHead + 1) & (FORTH_RX_SIZE - 1);
+        if (next == RxTail) {
+            RxLost++;                   // full, the VM has not read for FORTH_RX_SIZE characters
+            continue;
+        }
+        RxRing[RxHead] = c;
+        RxHead = next;
+    }
+}
+
+
+/**
+* Transmit interrupt, refills the UART from the ring. Once the ring is empty
+* the next character is written straight to the UART by PutTx(), which starts
+* the interrupts again.
+*/
+
+static void TxIsr(void) {
+    while (TxTail != TxHead && pc.writeable()) {
+        pc.putc(TxRing[TxTail]);
+        TxTail = (TxTail + 1) & (FORTH_TX_SIZE - 1);
+    }
+    if (TxTail == TxHead) {
+        TxIdle = TRUE;
+    }
+}
+
+
+/**
+* Queues a character for the UART.
+*
+* @param     c        the character
+*/
+
+static void PutTx(char c) {
+    int next;
+
+    while (1) {
+        __disable_irq();
+        if (TxIdle == TRUE) {
+            TxIdle = FALSE;
+            pc.putc(c);                 // nothing is being sent, the UART has room
+            __enable_irq();
+            return;
+        }
+        next = (TxHead + 1) & (FORTH_TX_SIZE - 1);
+        if (next != TxTail) {
+            TxRing[TxHead] = c;
+            TxHead = next;
+            __enable_irq();
+            return;
+        }
+        __enable_irq();
+
+#if FORTH_TX_DROP
+        TxLost++;
+        return;
+#endif
+        // full, the transmit interrupt makes room
+    }
+}
+
+
+/**
+*  @class   TxStream
+*  @brief   stdout of the board, see PutTx()
+*/
+
+class TxStream : public Stream {
+public:
+    TxStream(const char* name) : Stream(name) {}
+
+protected:
+    virtual int _putc(int c) {
+        PutTx(c);
+        return c;
+    }
+    virtual int _getc() {
+        return -1;
+    }
+};
+
+static TxStream console("console");
+
+
+/**
+* Starts buffering the console input and output.
+*/
+
+void ConsoleInit(void) {
+    pc.attach(&RxIsr, Serial::RxIrq);
+    pc.attach(&TxIsr, Serial::TxIrq);
+    freopen("/console", "w", stdout);
+    setvbuf(stdout, NULL, _IONBF, 0);   // the ring is the buffer
+}
+
+
+/**
+* Edits a line with the characters received so far and returns at once.
+* Characters are echoed, back space removes the last one and a character
+* which would not fit is answered with a bell. A line ends with CR, LF or
+* both, so that scripts pasted from any system are read line by line.
+*
+* @param     line     buffer of the line, holds it between the calls
+* @param     size     bytes \a line can hold, the NUL included
+*
+* @return    TRUE once \a line holds a whole line, FALSE if it goes on
+*/
+
+int ReadLine(char* line, int size) {
+    char c, end;
+
+    while (RxTail != RxHead) {
+        c = RxRing[RxTail];
+        RxTail = (RxTail + 1) & (FORTH_RX_SIZE - 1);
+
+        end = LineEnd;
+        LineEnd = 0;
+        if ((c == '\n' && end == '\r') || (c == '\r' && end == '\n')) {
+            continue;                   // second half of CR LF
+        }
+
+        if (c == '\r' || c == '\n') {
+            PutTx(c);
+            line[LinePos] = '\0';
+            LinePos = 0;
+            LineEnd = c;
+            if (RxLost > 0) {
+                printf ("%d characters lost, the console buffer was full \r\n", RxLost);
+                RxLost = 0;
+            }
+            return TRUE;
+        }
+
+        if (c == CONSOLE_BS || c == CONSOLE_DEL) {
+            if (LinePos > 0) {
+                LinePos--;
+                printf ("\b \b");
+            }
+            continue;
+        }
+
+        if (LinePos < size - 1) {
+            line[LinePos++] = c;
+            PutTx(c);
+        } else {
+            PutTx(CONSOLE_BELL);
+        }
+    }
+
+    return FALSE;
+}
+
+
+/**
+* Sleeps until an interrupt unless there is input to read or a ticker word
+* is due. The check is made with the interrupts off, an interrupt coming in
+* between still ends the sleep.
+*/
+
+void WaitForInput(void) {
+    __disable_irq();
+    if (RxTail == RxHead && TickPending == FALSE) {
+        __WFI();
+    }
+    __enable_irq();
+}
+
+
+/**
+* Waits until all of the output was handed to the UART. Output dropped with
+* FORTH_TX_DROP is reported once the ring is empty, so the report fits.
+*/
+
+void FlushConsole(void) {
+    int lost;
+
+    while (TxIdle == FALSE) {
+    }
+    lost = TxLost;
+    if (lost > 0) {
+        TxLost = 0;
+        printf ("\r\n%d characters of output lost \r\n", lost);
+        while (TxIdle == FALSE) {
+        }
+    }
+}
@@ -0,0 +1,52 @@
+/* Reconfigurable computing system
+ * Registration number: NXP3878 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * @file       console.h
+ * @brief      Serial console of the board, input and output buffered by the UART interrupts
+ */
+
+#ifndef __CONSOLE_H
+#define __CONSOLE_H
+
+#ifndef FORTH_RX_SIZE
+#define  FORTH_RX_SIZE       1024     /*< Bytes of input held while the VM is busy, a power of two */
+#endif
+
+#ifndef FORTH_TX_SIZE
+#define  FORTH_TX_SIZE       1024     /*< Bytes of output held while the UART sends them, a power of two */
+#endif
+
+#ifndef FORTH_TX_DROP
+#define  FORTH_TX_DROP          0     /*< 0 waits for room when the output ring is full, 1 drops and counts the bytes */
+#endif
+
+#define  CONSOLE_BELL        0x07     /*< Echoed for a character which does not fit on the line */
+#define  CONSOLE_BS          0x08     /*< Back space */
+#define  CONSOLE_DEL         0x7f     /*< Sent by many terminals for back space */
+
+void ConsoleInit(void);
+int ReadLine(char* line, int size);
+void WaitForInput(void);
+void FlushConsole(void);
+
+#endif
@@ -25,23 +25,314 @@
 *  @file    forth_files.c
 *  @brief   This file contains functions realted to handling of Forth files stored
 *           in a SD card
+*
+*           Nothing in here touches the card directly, the host build reads the
+*           files from the current directory instead. See sd_card.c for the
+*           parts which need the board.
 */
 
 #include "forth_files_int.h"
-
-SDFileSystem sd(p5, p6, p7, p9, "sd");
+#if FORTH_MMAP_SCRIPTS
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 extern int CmdPos;
-extern char CmdBuff[];
+extern char* CmdBuff;
+
+static struct ImageSource LoadedSrc[IMAGE_MAX_SOURCES];   /**< Scripts loaded so far, saved into images */
+static int LoadedSrcCnt;                                  /**< More than IMAGE_MAX_SOURCES once some went unrecorded */
+
+
+/**
+*  Tells whether two script names are the same file, the SD card does not tell
+*  upper from lower case. Names are kept as they were given so that the host,
+*  whose files do, can open the scripts again.
+*
+*  @param    a, b         the names, only IMAGE_NAME_SIZE-1 characters count
+*
+*  @return   TRUE or FALSE
+*/
+
+static int SameScript(const char* a, const char* b) {
+    char ua[IMAGE_NAME_SIZE], ub[IMAGE_NAME_SIZE];
+
+    strncpy(ua, a, IMAGE_NAME_SIZE-1);
+    ua[IMAGE_NAME_SIZE-1] = '\0';
+    strncpy(ub, b, IMAGE_NAME_SIZE-1);
+    ub[IMAGE_NAME_SIZE-1] = '\0';
+    ToUp(ua);
+    ToUp(ub);
+    return strcmp(ua, ub) == 0;
+}
+
+
+/**
+*  Records a script which was loaded without errors so that a saved image can
+*  tell later whether it is still up to date.
+*
+*  @param    file_name    name of the script relative to the SD card
+*  @param    sum          checksum of the script contents
+*/
+
+static void AddSource(char* file_name, unsigned int sum) {
+    int i;
+
+    if (strlen(file_name) >= IMAGE_NAME_SIZE) {
+        LoadedSrcCnt = IMAGE_MAX_SOURCES + 1;
+        return;
+    }
+
+    for (i=0; i<LoadedSrcCnt && i<IMAGE_MAX_SOURCES; i++) {
+        if (SameScript(LoadedSrc[i].name, file_name)) {
+            LoadedSrc[i].sum = sum;
+            return;
+        }
+    }
+
+    if (LoadedSrcCnt < IMAGE_MAX_SOURCES) {
+        strcpy(LoadedSrc[LoadedSrcCnt].name, file_name);
+        LoadedSrc[LoadedSrcCnt].sum = sum;
+    }
+    if (LoadedSrcCnt <= IMAGE_MAX_SOURCES) {
+        LoadedSrcCnt++;
+    }
+}
+
+
+#if FORTH_MMAP_SCRIPTS
+
+/**
+*  Maps a script into memory to be read by NextLine(). The lines are
+*  interpreted right in the mapping, which is read only.
+*
+*  @param    src          the script
+*  @param    path         its path
+*
+*  @return   FILE_FOUND or FILE_NOT_FOUND
+*/
+
+static int OpenSource(struct ScriptReader* src, char* path) {
+    struct stat st;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return FILE_NOT_FOUND;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return FILE_NOT_FOUND;
+    }
+
+    src->map = NULL;
+    src->size = st.st_size;
+    src->start = 0;
+    src->last = NULL;
+    if (src->size > 0) {                         // an empty file cannot be mapped
+        src->map = (const char*)mmap(NULL, src->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (src->map == MAP_FAILED) {
+        return FILE_NOT_FOUND;
+    }
+    if (src->map != NULL) {
+        madvise((void*)src->map, src->size, MADV_SEQUENTIAL);
+    }
+
+    src->sum = ImageChecksum(IMAGE_SUM_INIT, src->map, src->size);
+    return FILE_FOUND;
+}
+
+
+/**
+*  Returns the next line of a mapped script, ended by its newline. Only a last
+*  line without one is copied, there may be nothing after it in the mapping.
+*
+*  @param    src          the script
+*  @param    len          set to the length of the line
+*  @param    split        always FALSE, lines are not split
+*
+*  @return   the line, NULL at the end of the file
+*/
+
+static char* NextLine(struct ScriptReader* src, int* len, int* split) {
+    const char *line = src->map + src->start, *nl;
+    size_t left = src->size - src->start;
+
+    *split = FALSE;
+    if (left == 0) {
+        return NULL;
+    }
+
+    nl = (const char*)memchr(line, '\n', left);
+    if (nl == NULL) {
+        src->last = (char*)malloc(left + 1);
+        if (src->last == NULL) {
+            return NULL;
+        }
+        memcpy(src->last, line, left);
+        src->last[left] = '\0';
+        src->start = src->size;
+        *len = left;
+        return src->last;
+    }
+
+    *len = nl - line;
+    src->start += *len + 1;
+    return (char*)line;
+}
+
+
+/**
+*  Unmaps a script mapped by OpenSource().
+*
+*  @param    src          the script
+*/
+
+static void CloseSource(struct ScriptReader* src) {
+    if (src->map != NULL) {
+        munmap((void*)src->map, src->size);
+    }
+    free(src->last);
+}
+
+#else
+
+/**
+*  Opens a script to be read by NextLine().
+*
+*  @param    src          the script
+*  @param    path         its path
+*
+*  @return   FILE_FOUND or FILE_NOT_FOUND
+*/
+
+static int OpenSource(struct ScriptReader* src, char* path) {
+    stop_TS();
+    src->fp = fopen(path, "r");
+    start_TS();
+
+    src->start = src->end = 0;
+    src->eof = FALSE;
+    src->sum = IMAGE_SUM_INIT;
+    return src->fp == NULL ? FILE_NOT_FOUND : FILE_FOUND;
+}
+
+
+/**
+*  Reads the next sector of a script behind the data not interpreted yet, which
+*  is moved to the front of the buffer first.
+*
+*  @param    src          the script
+*/
+
+static void FillSource(struct ScriptReader* src) {
+    int room, len;
+
+    if (src->start > 0) {
+        memmove(src->buff, src->buff + src->start, src->end - src->start);
+        src->end -= src->start;
+        src->start = 0;
+    }
+
+    room = FORTH_SOURCE_SIZE - src->end;
+    stop_TS();                          // do not curropt the SPI bus
+    len = fread(src->buff + src->end, 1, room < FORTH_SECTOR_SIZE ? room : FORTH_SECTOR_SIZE, src->fp);
+    start_TS();
+
+    if (len <= 0) {
+        src->eof = TRUE;
+        return;
+    }
+    src->sum = ImageChecksum(src->sum, src->buff + src->end, len);
+    src->end += len;
+}
+
+
+/**
+*  Returns the next line of a script, ended by a NUL in place of its newline.
+*  A line longer than FORTH_SOURCE_SIZE is returned in pieces, split at the
+*  last blank so that no word is cut in two.
+*
+*  @param    src          the script
+*  @param    len          set to the length of the line
+*  @param    split        set to TRUE if the line goes on in the next piece
+*
+*  @return   the line, in the buffer of \a src, NULL at the end of the file
+*/
+
+static char* NextLine(struct ScriptReader* src, int* len, int* split) {
+    char *line, *nl;
+    int scanned = src->start;
+
+    *split = FALSE;
+    while (1) {
+        line = src->buff + src->start;
+        nl = (char*)memchr(src->buff + scanned, '\n', src->end - scanned);
+        if (nl != NULL) {
+            *nl = '\0';
+            *len = nl - line;
+            src->start = nl + 1 - src->buff;
+            return line;
+        }
+
+        if (src->eof == TRUE || src->end - src->start == FORTH_SOURCE_SIZE) {
+            if (src->start == src->end) {
+                return NULL;
+            }
+            nl = src->buff + src->end - 1;              // last line, or one too long for the buffer
+            if (src->eof == FALSE) {
+                while (nl > line && !IS_BLANK(*nl)) {
+                    nl--;
+                }
+            }
+            if (nl == line || src->eof == TRUE) {
+                nl = src->buff + src->end;              // the spare byte at the end
+                src->start = src->end;
+            } else {
+                src->start = nl + 1 - src->buff;        // the rest of the line follows from the last blank
+            }
+            *split = (src->eof == FALSE);
+            *nl = '\0';
+            *len = nl - line;
+            return line;
+        }
+
+        scanned = src->end - src->start;                // these have no newline, the rest moves to the front
+        FillSource(src);
+    }
+}
+
+
+/**
+*  Closes a script opened by OpenSource().
+*
+*  @param    src          the script
+*/
+
+static void CloseSource(struct ScriptReader* src) {
+    stop_TS();
+    fclose(src->fp);
+    start_TS();
+}
+
+#endif
 
 
 /**
 *  Given a file name, this function loads the forth code found in the file
 *  and executed it.
 *
+*  The file is read a sector at a time, or mapped into memory on a host with
+*  FORTH_MMAP_SCRIPTS, and the lines are interpreted where they were read to,
+*  \a CmdBuff points at the line. The line which loaded the file is picked up
+*  again where it left off.
+*
 *  @param    file_name    name of the Forth script
-*  @param       x         x location for the bit map
-*  @param       y         y location for the bit map
 *
 *  @return   EXECUTION_ERROR on execution error, FILE_NOT_FOUND if file could not be located,
 *            EXECUTION_COMPLETE if execution was completed
@@ -50,188 +341,177 @@ extern char CmdBuff[];
 int ExecFromFile(char* file_path) {
     char err_flag=FALSE;
     char file_name[60];
-    int saved_CmdPos, res;
-    char saved_CmdBuff[BUFFER_SIZE];
-    FILE* fp;
+    int saved_CmdPos, res, len, split, comment = FALSE;
+    char* saved_CmdBuff;
+    char* line;
+    struct ScriptReader src;
     char abs_file_name[60];                // absolute file name
 
-    stop_TS();
-
     // Remove spaces from file name that can cause problems
     RemoveSpaces(file_name, file_path);
 
-    strcpy(abs_file_name, "/sd/");
+    strcpy(abs_file_name, FORTH_FILE_ROOT);
     strcat(abs_file_name, file_name);
     printf ("Executing from file %s \n", file_name);
 
-    fp = fopen(abs_file_name, "r");
-
-    if (fp == NULL) {
+    if (OpenSource(&src, abs_file_name) != FILE_FOUND) {
         printf ("Could not open file \n");
         return FILE_NOT_FOUND;
     }
 
     saved_CmdPos = CmdPos;
-    strcpy(saved_CmdBuff, CmdBuff);
+    saved_CmdBuff = CmdBuff;
 
-    CmdPos = 0;                        // reset command buffer
-
-    while (feof(fp)==0) {
-        stop_TS();                      // do not curropt the SPI bus
-        fgets(CmdBuff, BUFFER_SIZE, fp);
-        start_TS();
-        printf ("%s", CmdBuff);
-        ToUp(CmdBuff);
+    while ((line = NextLine(&src, &len, &split)) != NULL) {
+        printf ("%.*s\n", len, line);
 
+        CmdBuff = line;
+        RESET_CMDPOS;
+        LineComment = FALSE;
         res = CONTINUE_FORTH_INTERPRET;
 
-        while (CmdBuff[CmdPos] != '\0') {
+        while (comment == FALSE && !IS_EOL(CmdBuff[CmdPos])) {
             res = Interpret();
             if (res == COMPILE_ERROR || res == STOP_FORTH_INTERPRET ) {
                 err_flag = TRUE;
                 break;
             }
         }
-
-        RESET_CMDPOS;
-        if ( res != CONTINUE_FORTH_COMPILE) {
-            //printf ( " OK \n");
-
-        }
-
+        comment = split && (comment || LineComment);       // the comment goes on in the next piece
     }
-    fclose(fp);
+
+    CloseSource(&src);
+    LineComment = FALSE;
     CmdPos = saved_CmdPos;
-    strcpy(CmdBuff, saved_CmdBuff);
+    CmdBuff = saved_CmdBuff;
 
     if (err_flag == TRUE) {
         return EXECUTION_ERROR;
     } else {
+        AddSource(file_name, src.sum);
         return EXECUTION_COMPLETE;
     }
 
 }
 
 /**
-* This function draws a bitmap image on LCD.
+* Computes the checksum of a script the same way ExecFromFile() does while
+* loading it.
 *
-* @param     file_name      Image location of the file
+* @param     file_name      name of the script relative to the SD card
+* @param     sum            checksum of the contents
 *
-* @return    FILE_NOT_FOUND on error or else FILE_FOUND on success
+* @return    FILE_NOT_FOUND or FILE_FOUND
 */
 
-int DrawBMP(int x, int y, char *file_name) {
-    char abs_path[50] = "/sd/";
-    unsigned int i;
-    int height, width;
-    unsigned short temp;
-    int r,g,b;
-    r = g = b = 0;
-    stop_TS();
+static int ScriptChecksum(char* file_name, unsigned int* sum) {
+    char abs_path[60] = FORTH_FILE_ROOT, buff[64];
+    FILE* fp;
+    int len;
 
     strcat(abs_path, file_name);
-    FILE *fp = fopen(abs_path, "r");
+    fp = fopen(abs_path, "r");
     if (fp == NULL) {
-        start_TS();
         return FILE_NOT_FOUND;
-    } else {
-        // get height and width of the bit map
-        fseek(fp, 16, SEEK_SET);
-        width = 0;
-        char ch;
-        for (i=0; i<2; i++) {
-            ch=fgetc(fp);
-            width = ch;
-            ch=fgetc(fp);
-            width = (ch << 8)| width;
-        }
-        height = 0;
-        for (i=0; i<2; i++) {
-            ch=fgetc(fp);
-            height = ch;
-            ch=fgetc(fp);
-            height = ch << 8| height;
-        }
-
-
-        fseek(fp, 0x36, SEEK_SET);
-        LCD_WR_REG(0x0003,0x1038);  // set entry mode
-
-
-        LCD_WR_REG(0x0020,0x0000);
-        LCD_WR_REG(0x0021,00000);
-
+    }
 
-        LCD_SetBox(x, y, height, width);   // select the area for drawing
+    *sum = IMAGE_SUM_INIT;
+    while ((len = fread(buff, 1, sizeof(buff), fp)) > 0) {
+        *sum = ImageChecksum(*sum, buff, len);
+    }
+    fclose(fp);
 
+    return FILE_FOUND;
+}
 
-        LCD_WR_REG16(0x0022);
 
+/**
+* Saves the user dictionary into an image on the SD card. The scripts loaded
+* so far are recorded in the image so that InitExec() can check it is still
+* up to date.
+*
+* @param     file_name      name of the image file
+*
+* @return    IMAGE_OK or one of the IMAGE_ERR codes
+*/
 
-        for (i=0;r!=EOF;i++) {
-            b=fgetc(fp);
-            g=fgetc(fp);
-            r=fgetc(fp);
-            temp=RGB(r,g,b);
-            LCD_WR_DATA16(temp);
-        }
+int SaveImageFile(char* file_name) {
+    char abs_path[60] = FORTH_FILE_ROOT;
+    FILE* fp;
+    int ret;
 
-        LCD_WR_REG(0x0003,0x1028);      // restore the Entry mode so that fonts behave as expected
-        LCD_WR_REG(0x0020,0x0000);
-        LCD_WR_REG(0x0021,0x0000);
+    stop_TS();
+    strcat(abs_path, file_name);
+    fp = fopen(abs_path, "wb");
+    if (fp == NULL) {
         start_TS();
-        return FILE_FOUND;
+        return IMAGE_ERR_IO;
     }
+
+    ret = SaveImage(fp, LoadedSrc, LoadedSrcCnt);
+    fclose(fp);
+    start_TS();
+
+    return ret;
 }
 
 
 /**
-* This function looks out for the init script in the SD card
-* and if it finds one, the script will be executed.
-* The init script consists of Forth scripts that can be loaded
-* into the system.
-*
-* @return FILE_NOT_FOUND if file could not be located or state of the
-*         execution of words from the file as specified in \a INIT_FILE
-*         file
+* Loads an image if it was built from \a script and none of the scripts it
+* was built from changed since.
+*
+* @param     image          name of the image file
+* @param     script         boot script named in the init file
+*
+* @return    IMAGE_OK when the image was loaded
 */
 
-int InitExec(void) {
-    FILE *fp=NULL;
-    char script[MAX_EXEC_FILES];
-    char buff[90]="Executing from file ", temp[40];
-    int ret;
+int LoadImageFile(char* image, char* script) {
+    char abs_path[60] = FORTH_FILE_ROOT;
+    struct ImageHeader hdr;
+    unsigned int sum;
+    int i, found = 0, ret;
+    FILE* fp;
 
     stop_TS();
-    // try and open the init file
-    fp = fopen(INIT_FILE, "r");
-
+    strcat(abs_path, image);
+    fp = fopen(abs_path, "rb");
     if (fp == NULL) {
-        return FILE_NOT_FOUND;
+        start_TS();
+        return IMAGE_ERR_IO;
     }
 
-    // get the files
-
+    ret = ReadImageHeader(fp, &hdr);
+    if (ret == IMAGE_OK && (hdr.sources < 1 || hdr.sources > IMAGE_MAX_SOURCES)) {
+        ret = IMAGE_ERR_VERSION;                 // did not record all of its scripts
+    }
 
-    fgets(temp, MAX_FILE_NAME, fp);
-    if (buff[0] == '\r' || buff[0] == '\n' || buff[0] == '\0') {
-        return FILE_NOT_FOUND;
+    for (i=0; ret == IMAGE_OK && i<hdr.sources; i++) {
+        hdr.source[i].name[IMAGE_NAME_SIZE-1] = '\0';
+        if (SameScript(hdr.source[i].name, script)) {
+            found = 1;
+        }
+        if (ScriptChecksum(hdr.source[i].name, &sum) != FILE_FOUND || sum != hdr.source[i].sum) {
+            printf ("%s changed since image %s was saved \n", hdr.source[i].name, image);
+            ret = IMAGE_ERR_VERSION;
+        }
     }
-    RemoveSpaces(script, temp);
-    strcat(buff, script);
-    strcat(buff, " ...");
-    LCD_write_string(10, 20, (unsigned char*)buff, RED, WHITE);
-    wait(1);
-    LCD_Clear(WHITE);
-    ret = ExecFromFile(script);
-    if (ret == FILE_NOT_FOUND) {
-        printf ("\nCould not locate file %s \n", buff);
-        LCD_Clear(RED);
-        return FILE_NOT_FOUND;
+    if (ret == IMAGE_OK && found == 0) {
+        ret = IMAGE_ERR_VERSION;
     }
 
-    return ret;                      // let the main know error conditions in script if any
-}
-
+    if (ret == IMAGE_OK) {
+        ret = LoadImage(fp);
+    }
+    fclose(fp);
+    start_TS();
 
+    if (ret == IMAGE_OK) {
+        memcpy(LoadedSrc, hdr.source, sizeof(LoadedSrc));
+        LoadedSrcCnt = hdr.sources;
+    } else {
+        printf ("Not using image %s (error %d) \n", image, ret);
+    }
 
+    return ret;
+}
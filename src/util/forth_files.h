@@ -27,11 +27,17 @@
 
 
 
+#ifndef FORTH_FILE_ROOT
+#define  FORTH_FILE_ROOT        "/sd/" /*< Directory the scripts are loaded from, the host build uses the current directory */
+#endif
+
 #define  FILE_NOT_FOUND         1     /*< Error code if file was not found */
 #define  FILE_FOUND             2     /*< To indicate file found condition */
 
 int ExecFromFile(char* file_name);
 int DrawBMP(int x, int y, char *file_name);
 int InitExec(void);
+int SaveImageFile(char* file_name);
+int LoadImageFile(char* image, char* script);
 
 #endif
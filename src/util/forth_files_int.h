@@ -24,13 +24,15 @@
 #ifndef __FORTH_FILES_INT_H
 #define __FORTH_FILES_INT_H
 
-#include "SDFileSystem.h"
+#include <stdio.h>
+#include <string.h>
 #include "interprter.h"
 #include "utils.h"
 #include "forth_files.h"
-#include "gui.h"
+#include "ts.h"
+#include "image.h"
 
-#define  INIT_FILE         "/sd/init"     /*< The init file name which should list the scripts to be loaded at boot time */
+#define  INIT_FILE         FORTH_FILE_ROOT "init"     /*< The init file name which should list the scripts to be loaded at boot time */
 #define  MAX_EXEC_FILES        4          /*< Maximum files allowed in init file */
 
 #define  FILE_NOT_FOUND         1     /*< Error code if file was not found */
@@ -40,6 +42,41 @@
 #define INIT_F_CLR              RED    /*< Foreground color for displaying the script file names */
 #define INIT_B_CLR             WHITE   /*< Background color for displaying the scripts file name */
 
+#ifndef FORTH_MMAP_SCRIPTS
+#define  FORTH_MMAP_SCRIPTS     0     /*< 1 maps the scripts into memory instead of reading them, on a host with mmap() */
+#endif
+
+#ifndef FORTH_SECTOR_SIZE
+#define  FORTH_SECTOR_SIZE    512     /*< Bytes of a script read from the card at a time */
+#endif
+
+#ifndef FORTH_SOURCE_SIZE
+#define  FORTH_SOURCE_SIZE   (2*FORTH_SECTOR_SIZE)   /*< Buffer of a script being loaded, longer lines are split between two words */
+#endif
+
+/**
+*  A script being loaded. Whole sectors are read into \a buff and every line is
+*  interpreted right where it is, a line running over the end of the data read
+*  so far is moved to the front first. With FORTH_MMAP_SCRIPTS all of the file
+*  is mapped and the lines are interpreted in the mapping.
+*/
+
+struct ScriptReader {
+#if FORTH_MMAP_SCRIPTS
+    const char* map;                         /*< The file, read only */
+    size_t size;                             /*< Its length */
+    size_t start;                            /*< Next line */
+    char* last;                              /*< Copy of a last line without a newline */
+#else
+    FILE* fp;
+    char buff[FORTH_SOURCE_SIZE+1];          /*< One more for the NUL ending the last line */
+    int start;                               /*< Next line */
+    int end;                                 /*< End of the data read */
+    int eof;                                 /*< TRUE once all of the file was read */
+#endif
+    unsigned int sum;                        /*< Checksum of the data read, see ImageChecksum() */
+};
+
 int ExecFromFile(char* file_name);
 
 #endif
@@ -24,8 +24,13 @@
 #ifndef __TYPES_H
 #define __TYPES_H
 
-typedef unsigned char uint8_t;
-typedef unsigned int  uint32_t;
+#include <stdint.h>
+#include <inttypes.h>
+
+typedef intptr_t  cell;                 /**< Forth cell, wide enough to hold an address or an execution token */
+typedef uintptr_t ucell;                /**< Unsigned cell */
+
+#define  CELL_FMT   "%" PRIdPTR        /**< printf format for a cell */
 
 #define  TRUE    1
 #define  FALSE   0
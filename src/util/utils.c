@@ -38,15 +38,12 @@
 
 void ReplaceQuotes(char *str) {
     int n;
-    char buff[30];
     if (str[0] == '\"') {
-        strcpy(buff, ++str);
-        str--;
-        strcpy(str, buff);
+        memmove(str, str + 1, strlen(str));     // the NUL moves along
     }
     n = strlen(str);
 
-    if (str[n-1] == '\"') {
+    if (n > 0 && str[n-1] == '\"') {
         str[n-1] = '\0';
     }
 }
@@ -82,6 +79,33 @@ void ToUp(char *str) {
     }
 }
 
+/**
+*  Class of every character, for the lexer. The low 6 bits hold the value of the character as a digit,
+*  0 to 35 for 0-9, A-Z and a-z, and CHAR_NODIGIT for the others. CHAR_BLANK marks the characters which
+*  end a token, the control characters, space and the NUL ending the line. CHAR_LOWER marks a to z.
+*
+*  @see IS_BLANK(), TO_UPPER(), DIGIT_OF()
+*/
+
+const unsigned char CharClass[256] = {
+    0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f,   /* 00 */
+    0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f,   /* 10 */
+    0x7f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* 20 */
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* 30 */
+    0x3f, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,   /* 40 */
+    0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* 50 */
+    0x3f, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f, 0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98,   /* 60 */
+    0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f, 0xa0, 0xa1, 0xa2, 0xa3, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* 70 */
+    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* 80 */
+    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* 90 */
+    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* a0 */
+    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* b0 */
+    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* c0 */
+    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* d0 */
+    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* e0 */
+    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f,   /* f0 */
+};
+
 /**
 * This function simply returns the color value for given index
 * @param   clr     color index
@@ -32,6 +32,16 @@
 #define  EXECUTION_ERROR          1
 #define  EXECUTION_COMPLETE       2
 
+#define  CHAR_NODIGIT          0x3f      /**< Digit value of a character which is no digit, above every base */
+#define  CHAR_BLANK            0x40      /**< The character ends a token */
+#define  CHAR_LOWER            0x80      /**< The character is a lower case letter */
+
+#define  IS_BLANK(c)    (CharClass[(unsigned char)(c)] & CHAR_BLANK)       /**< Non zero if \a c ends a token */
+#define  TO_UPPER(c)    ((c) - ((CharClass[(unsigned char)(c)] & CHAR_LOWER) >> 2))   /**< \a c in upper case */
+#define  DIGIT_OF(c)    (CharClass[(unsigned char)(c)] & CHAR_NODIGIT)     /**< Value of \a c as a digit */
+
+extern const unsigned char CharClass[256];
+
 void ReplaceQuotes(char *str);
 void ToUp(char* str);
 unsigned int ColorVal(int clr);
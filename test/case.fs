@@ -0,0 +1,43 @@
+\ CASE ... OF ... ENDOF ... ENDCASE, dense literals become a jump table, anything else is compared in turn.
+\ 12345 is left below everything and must be all that is left at the end.
+12345
+: check ( flag -- ) cr if ." ok" else ." FAIL" then cr ;
+
+\ dense literals, the jump table, with the default clause seeing the selector
+: dense case 0 of 10 endof 1 of 11 endof 2 of 12 endof 3 of 13 endof dup 100 + swap endcase ;
+0 dense 10 = check
+3 dense 13 = check
+4 dense 104 = check
+-1 dense 99 = check
+
+\ sparse literals and values computed at run time are compared one by one
+: sparse case 1 of 1 endof 100 of 2 endof 10000 of 3 endof 0 swap endcase ;
+100 sparse 2 = check
+10000 sparse 3 = check
+5 sparse 0 = check
+variable sel 7 sel !
+: computed case sel @ of 1 endof sel @ 1 + of 2 endof 0 swap endcase ;
+8 computed 2 = check
+9 computed 0 = check
+
+\ nested CASE, inside an OF and in the default clause
+: nest ( a b -- n )
+  swap case
+    1 of case 1 of 11 endof 2 of 12 endof 10 swap endcase endof
+    2 of case 1 of 21 endof 2 of 22 endof 20 swap endcase endof
+    swap case 1 of 31 endof 30 swap endcase swap
+  endcase ;
+1 2 nest 12 = check
+2 1 nest 21 = check
+2 7 nest 20 = check
+3 1 nest 31 = check
+3 5 nest 30 = check
+
+\ CASE in a loop and on a line
+: count2 0 6 0 do i case 2 of 1 + endof 4 of 1 + endof endcase loop ;
+count2 2 = check
+2 case 1 of 5 endof 2 of 6 endof 0 swap endcase 6 = check
+
+12345 = check
+
+." All checks run" cr
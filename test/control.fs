@@ -0,0 +1,76 @@
+\ A control word out of place drops the whole definition, an older word of the same name stays, and the
+\ rest of its line. 12345 is left below everything and must be all that is left at the end.
+12345
+: check ( flag -- ) cr if ." ok" else ." FAIL" then cr ;
+
+: lv 1 ;
+: lv dup if leave then ; 99
+lv 1 = check
+
+: eo 2 ;
+: eo 2 case 1 of 5 endof endof endcase ; 99
+eo 2 = check
+
+: oc 3 ;
+: oc 1 of ; 99
+oc 3 = check
+
+: ec 4 ;
+: ec endcase ; 99
+ec 4 = check
+
+: ul 5 ;
+: ul unloop ; 99
+ul 5 = check
+
+: lp 6 ;
+: lp loop ; 99
+lp 6 = check
+
+\ I needs a loop around it and J two, in the same definition
+: ii 13 ;
+: ii i ; 99
+ii 13 = check
+
+: jj 14 ;
+: jj 3 0 do j loop ; 99
+jj 14 = check
+
+\ the control words keep their places apart from the stack of the user
+: y1 7 ;
+7 8 : y1 then ; 99
+8 = swap 7 = and check
+y1 7 = check
+
+\ every structure has to be closed by ; and in the order they were opened
+: b2 8 ;
+: b2 if 5 ;
+b2 8 = check
+
+: b3 9 ;
+: b3 1 if 2 ;
+b3 9 = check
+
+: lo 10 ;
+: lo 5 0 do ;
+lo 10 = check
+
+: mx 11 ;
+: mx dup if begin dup then until ;
+mx 11 = check
+
+: cx 12 ;
+: cx case 1 of 5 endof dup if endcase then ;
+cx 12 = check
+
+\ the same words in the right places still compile
+: fine 0 swap case 1 of 10 + endof 2 of 20 + endof endcase 5 0 do i 3 = if leave then 1 + loop ;
+1 fine 13 = check
+: ij 0 3 0 do 2 0 do j 2 * i + + loop loop ;
+ij 15 = check
+: wh begin dup while 1 - repeat ;
+3 wh 0 = check
+
+12345 = check
+
+." All checks run" cr
@@ -0,0 +1,18 @@
+\ Division by zero leaves 0, so "/" is ( a b -- c ) whatever b is and words using it
+\ can be verified. 12345 is left below everything and must be all that is left at the end.
+12345
+: check ( flag -- ) cr if ." ok" else ." FAIL" then cr ;
+
+7 0 / 0 = check
+
+: d0 0 / ;
+99 7 d0  0 = swap 99 = and check
+
+: bad 0 0 / 0 0 / 0 0 / 0 0 / drop drop drop drop 1 2 3 4 5 6 ;
+99 bad  6 = swap 5 = and swap 4 = and swap 3 = and swap 2 = and swap 1 = and swap 99 = and check
+
+: a1 1 2 3 . . . 0 0 / dup ;
+a1  0 = swap 0 = and check
+
+12345 = check
+." All checks run" cr
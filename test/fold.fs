@@ -0,0 +1,61 @@
+\ Arithmetic and logic on literals is done when a word is compiled, IF after a literal leaves out its dead arm.
+\ 12345 is left below everything and must be all that is left at the end.
+12345
+: check ( flag -- ) cr if ." ok" else ." FAIL" then cr ;
+
+\ folded words give what the same words give at run time
+variable a 1000 a !
+variable b 4 b !
+: f1 1000 4 * + ;
+: r1 a @ b @ * + ;
+5 f1 5 r1 = check
+5 f1 4005 = check
+: f2 1000 4 / 7 - -3 * ;
+: r2 a @ b @ / 7 - -3 * ;
+f2 r2 = check
+f2 -729 = check
+: f3 6 3 and 5 or 12 xor not ;
+: r3 6 3 and 5 or b @ 3 * xor not ;
+f3 r3 = check
+: f4 2 3 < 3 2 > 4 4 = 4 4 <= 5 4 >= and and and and ;
+: r4 2 b @ 1 - < b @ 1 - 2 > b @ 4 = b @ 4 <= 5 b @ >= and and and and ;
+f4 r4 = check
+: f6 3 2 < 2 3 > or ;
+: r6 b @ 1 - 2 < 2 b @ 1 - > or ;
+f6 r6 = check
+: f5 12 2 ?bitset 12 0 ?bitset ;
+: r5 12 b @ 2 - ?bitset 12 b @ 4 - ?bitset ;
+f5 r5 rot = rot rot = and check
+
+\ the division by zero folds to 0 like it runs
+: fz 5 0 / ;
+fz 0 = check
+
+\ a folded word is as big as one written with the result
+here : aa 1000 4 * + ; here swap -
+here : bb 4000 + ; here swap -
+= check
+
+\ 0 IF leaves the arm out, 1 IF the branch, ELSE arms included
+here : cc 0 if 1 2 3 4 5 then 7 ; here swap -
+here : dd 7 ; here swap -
+= check
+: ee 1 if 8 else 9 then ;
+ee 8 = check
+: ff 0 if 8 else 9 then ;
+ff 9 = check
+: gg 3 0 do i 0 if leave then loop 11 ;
+gg 11 = swap 2 = and swap 1 = and swap 0 = and check
+
+\ nothing folds across a control word or on into a word which is not pure
+: hh 1 if 2 then 3 + ;
+hh 5 = check
+: ii 2 dup + ;
+ii 4 = check
+
+\ lines fold the same way
+2 3 + 4 * 20 = check
+
+12345 = check
+
+." All checks run" cr
@@ -0,0 +1,54 @@
+\ FORGET and MARKER give back a word, everything defined after it and the space they took.
+\ 12345 is left below everything and must be all that is left at the end.
+12345
+: check ( flag -- ) cr if ." ok" else ." FAIL" then cr ;
+
+\ FORGET brings back the older word of the same name and gives the space back
+: w 1 ;
+here
+: w 2 ;
+variable v 5 v !
+: uses-w w 10 + ;
+w 2 = check
+uses-w 12 = check
+forget w
+here = check
+w 1 = check
+
+\ a marker forgets itself and everything after it, callers and variables included
+here
+marker mark
+: m1 100 ;
+variable mv
+: m2 m1 mv ! mv @ 1 + ;
+m2 101 = check
+mark
+here = check
+
+\ the space given back is used again, by a word of the same name too
+here
+marker again
+: m1 200 ;
+m1 200 = check
+again
+here = check
+
+\ markers nest, each one going back to where it was made
+marker outer
+: o1 1 ;
+here
+marker inner
+: i1 2 ;
+o1 i1 + 3 = check
+inner
+here = check
+o1 1 = check
+outer
+
+\ inbuilt words stay
+forget dup
+3 dup + 6 = check
+
+12345 = check
+
+." All checks run" cr
@@ -0,0 +1,23 @@
+\ Run after image.fs was loaded from the image it saved, see image.fs.
+\ 12345 is left below everything and must be all that is left at the end.
+12345
+
+counter @ 42 = check
+bump 43 = check
+bump 44 = check
+5 sq 25 = check
+4 sum-sq 14 = check
+2 pick3 12 = check
+7 pick3 99 = check
+1000 countdown 0 = check
+greet 1 check
+uses-old 11 = check
+old 2 = check
+
+\ words defined after the image was loaded go on from where it ends
+: more bump sq ;
+more 2025 = check
+
+12345 = check
+
+." All checks run" cr
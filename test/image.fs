@@ -0,0 +1,14 @@
+\ Words saved into an image by the image test and checked by image-check.fs once the image is loaded back:
+\   forth-repl image.fs, then SAVE-IMAGE image.img, then forth-repl -i image.img image.fs image-check.fs
+: check ( flag -- ) cr if ." ok" else ." FAIL" then cr ;
+
+variable counter 42 counter !
+: bump ( -- n ) counter @ 1 + dup counter ! ;
+: sq ( n -- n*n ) dup * ;
+: sum-sq ( n -- s ) 0 swap 0 do i sq + loop ;
+: pick3 ( n -- m ) case 0 of 10 endof 1 of 11 endof 2 of 12 endof 99 swap endcase ;
+: countdown ( n -- 0 ) dup 0 > if 1 - recurse then ;
+: greet ." saved" ;
+: old 1 ;
+: uses-old old 10 + ;
+: old 2 ;
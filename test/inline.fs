@@ -0,0 +1,44 @@
+\ Short words of your own are copied into their callers, INLINE and NOINLINE override the size limit.
+\ 12345 is left below everything and must be all that is left at the end.
+12345
+: check ( flag -- ) cr if ." ok" else ." FAIL" then cr ;
+
+\ inlined words with branches, loops, variables and strings keep doing what they did
+: sign ( n -- -1|0|1 ) dup 0 < if drop -1 else 0 > if 1 else 0 then then ;
+: signs -5 sign 0 sign 7 sign ;
+signs 1 = swap 0 = and swap -1 = and check
+: tri ( n -- t ) 0 swap 1 + 0 do i + loop ;
+: tri2 tri tri ;
+3 tri2 21 = check
+variable v
+: v+ ( n -- ) v @ + v ! ;
+: bump 5 0 do 2 v+ loop ;
+0 v ! bump v @ 10 = check
+: hi ." hi" ;
+: hi2 hi hi 1 ;
+hi2 1 = check
+
+\ a caller of an inlined word holds a copy of its code, a caller of a NOINLINE word only calls it
+: w3 swap 1 + ;
+: w4 swap 1 + ; NOINLINE
+here : c3 w3 drop ; here swap -
+here : c4 w4 drop ; here swap -
+> check
+1 2 c3 2 = check
+1 2 c4 2 = check
+
+\ INLINE copies a word whatever its size
+: long 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 + 1 + ; INLINE
+: long2 long long ;
+0 long2 20 = check
+
+\ callers keep the code of a word redefined after them, as they would with a call
+: k 1 ;
+: uses-k k 10 + ;
+: k 2 ;
+uses-k 11 = check
+k 2 = check
+
+12345 = check
+
+." All checks run" cr
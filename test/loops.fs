@@ -0,0 +1,45 @@
+\ Counted loops: DO, ?DO, LOOP, +LOOP, LEAVE, I and J, in definitions and on lines.
+\ 12345 is left below everything and must be all that is left at the end.
+12345
+: check ( flag -- ) cr if ." ok" else ." FAIL" then cr ;
+
+: sum10 0 10 0 do i + loop ;
+sum10 45 = check
+: once 0 5 4 do i + loop ;
+once 4 = check
+
+\ ?DO skips the body when limit and start are equal, DO runs it once
+: qnone 0 3 3 ?do i + 1000 + loop ;
+qnone 0 = check
+: qtwo 0 3 1 ?do i + 1000 + loop ;
+qtwo 2003 = check
+
+\ +LOOP up and down, stopping when the index crosses the limit
+: evens 0 10 0 do i + 2 +loop ;
+evens 20 = check
+: down 0 0 10 do i + -3 +loop ;
+down 22 = check
+: steps 0 0 0 do 1 + -1 +loop ;
+steps 1 = check
+
+\ LEAVE goes to the end of the innermost loop only
+: first5 0 100 0 do i 5 = if leave then 1 + loop ;
+first5 5 = check
+: inner 0 3 0 do 10 0 do i 2 = if leave then 1 + loop loop ;
+inner 6 = check
+
+\ I and J in nested loops
+: grid 0 3 0 do 4 0 do j 10 * i + + loop loop ;
+grid 138 = check
+
+\ a loop on a line runs when it is closed, over several lines too
+0 5 0 do i + loop 10 = check
+0
+4 0 do
+  i +
+loop
+6 = check
+
+12345 = check
+
+." All checks run" cr
@@ -0,0 +1,39 @@
+\ Numbers: BASE, the prefixes $ (hex), % (binary) and # (decimal) and a - after the prefix.
+\ 12345 is left below everything and must be all that is left at the end.
+12345
+: check ( flag -- ) cr if ." ok" else ." FAIL" then cr ;
+
+-5 0 5 - = check
+$ff 255 = check
+$FF 255 = check
+$-10 -16 = check
+%1010 10 = check
+%-11 -3 = check
+#99 99 = check
+#-99 0 99 - = check
+$7fffffff 2147483647 = check
+
+\ the same compiled into a word
+: nums $10 %11 #-7 -1 ;
+nums -1 = swap -7 = and swap 3 = and swap 16 = and check
+
+\ BASE is used without a prefix, # still means decimal
+16 base
+10 #16 = check
+-a #-10 = check
+ff #255 = check
+#10 base
+10 $a = check
+
+\ - alone is subtraction, a word which is not all digits is looked up
+7 3 - 4 = check
+: 1+ 1 + ;
+5 1+ 6 = check
+: $g 42 ;
+$g 42 = check
+: -x 43 ;
+-x 43 = check
+
+12345 = check
+
+." All checks run" cr
@@ -0,0 +1,32 @@
+\ RECURSE, and calls to words of your own made last, which are jumps and take no return stack.
+\ 12345 is left below everything and must be all that is left at the end.
+12345
+: check ( flag -- ) cr if ." ok" else ." FAIL" then cr ;
+
+\ recursion which returns through every level, well within the 50 cells of the return stack
+: fact ( n -- n! ) dup 1 > if dup 1 - recurse * then ;
+6 fact 720 = check
+: fib ( n -- f ) dup 1 > if dup 1 - recurse swap 2 - recurse + then ;
+15 fib 610 = check
+
+\ RECURSE last runs in constant return stack space, far deeper than the return stack
+: countdown ( n -- 0 ) dup 0 > if 1 - recurse then ;
+10000 countdown 0 = check
+: sum-to ( acc n -- acc' ) dup 0 = if drop else swap over + swap 1 - recurse then ;
+0 10000 sum-to 50005000 = check
+
+\ so does a call to another word made last, and a chain of them
+: step ( n -- n-1 ) 1 - ;
+: ends-in-call ( n -- n-1 ) dup drop step ;
+: chain ( n -- n-2 ) step ends-in-call ;
+5 chain 3 = check
+: walk ( n -- 0 ) dup 0 > if chain recurse then ;
+10001 walk -1 = check
+
+\ a word which recurses last from inside a loop is not a tail call, the loop is still open
+: nest ( n -- n ) dup 0 > if 1 0 do 1 - recurse loop then ;
+3 nest 0 = check
+
+12345 = check
+
+." All checks run" cr